@@ -0,0 +1,69 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PCI_SSD_BACKEND_H
+#define PCI_SSD_BACKEND_H
+
+#include "common.h"
+
+namespace PCISSD
+{
+	typedef CallbackBase <void, uint, uint64_t, uint64_t> BackendCompleteCB;
+
+	// Interface to the storage model behind the SSD controller.
+	// Each request is a byte range. It completes through the read or write callback with the same
+	// start address it was issued with. Only one request per start address may be outstanding.
+	// Every SSD_Device owns its own backend, so backends must not share state between instances.
+	class Backend
+	{
+		public:
+		virtual ~Backend() {}
+
+		virtual bool addTransaction(bool isWrite, uint64_t addr, uint64_t size) = 0;
+		virtual void update() = 0;
+		virtual void RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone) = 0;
+		virtual void printLogfile(ostream &out) = 0;
+
+		// Largest request the backend accepts, in bytes. Transactions are split at multiples of this size.
+		// 0 means the whole transaction can be sent as one request.
+		virtual uint64_t Max_Request_Size() = 0;
+
+		// Apply the lasting effects of a request (such as remapping written pages) without simulating its timing
+		// or making a callback. Used to fast-forward between detailed windows in sampled simulation.
+		virtual void Functional_Access(bool isWrite, uint64_t addr, uint64_t size) = 0;
+
+		// Write the backend state to a checkpoint, and read it back into a backend built with the same settings.
+		// Callbacks and ids are not part of the state.
+		virtual void Save(ostream &out) = 0;
+		virtual void Restore(istream &in) = 0;
+	};
+}
+
+#endif
@@ -0,0 +1,272 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+// Benchmark driver for the simulator's own speed.
+// Runs a fixed suite of workloads against the stub backend (BACKEND_STUB), so the time measured is spent in
+// PCI_SSD and not in a storage model. Each benchmark runs alone in a forked process and reports one CSV row:
+// the wall time, simulated cycles and requests per wall second, the number and size of heap allocations made
+// during the run, and the peak RSS of the process.
+//
+// Usage: PCI_SSD_Bench [-l LABEL] [-c CONFIG] [-o CSV] [-s SCALE] [BENCHMARK ...]
+//     -l LABEL   value of the label column, such as the commit being measured (default: none)
+//     -c CONFIG  ini file applied before the benchmark settings
+//     -o CSV     file to append the rows to, with a header if it is new (default: stdout)
+//     -s SCALE   multiply the request count of every benchmark (default: 1)
+// With no BENCHMARK names, the whole suite runs. "make bench" builds this and appends a run labeled with
+// the current commit to bench.csv, so results can be compared across commits.
+
+#include "SweepRun.h"
+#include <algorithm>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace PCISSD;
+
+// Count every heap allocation in the process. The benchmarks run one per process, so these are not atomic.
+static uint64_t allocations = 0;
+static uint64_t allocated_bytes = 0;
+
+void *operator new(size_t size)
+{
+	allocations++;
+	allocated_bytes += size;
+
+	void *p = malloc(size ? size : 1);
+	if (p == NULL)
+		throw bad_alloc();
+	return p;
+}
+
+void operator delete(void *p) noexcept
+{
+	free(p);
+}
+
+class Benchmark
+{
+	public:
+	const char *name;
+	const char *workload; // Workload spec (see Workload.h).
+	uint64_t queue_depth;
+	uint64_t sg_entry_size; // Bytes per SG entry, or 0 for no DMA.
+};
+
+// Sizes are in sectors, so 8 is 4 KB, 256 is 128 KB and 2048 is 1 MB.
+const Benchmark SUITE[] =
+{
+	{"rand_read_4k_qd1", "random:4000:100:8", 1, 0},
+	{"rand_read_4k_qd32", "random:40000:100:8", 32, 0},
+	{"seq_write_128k", "sequential:2000:0:256", 32, 0},
+	{"mixed_1m", "random:400:70:2048", 8, 0},
+	{"dma_sg_128k", "random:500:50:256", 16, 4096},
+};
+const uint64_t NUM_BENCHMARKS = sizeof(SUITE) / sizeof(SUITE[0]);
+
+// Host memory answers DMA accesses after this many external cycles.
+const uint64_t HOST_DELAY = 50;
+
+string bench_header()
+{
+	return "label,benchmark,status,requests,sim_cycles,wall_s,cycles_per_s,requests_per_s,allocations,alloc_mb,peak_rss_kb";
+}
+
+// Runs one benchmark and returns its row, without the label and name.
+string run_benchmark(const Benchmark &b, Config config, uint64_t scale)
+{
+	// Scale the request count, which is always the second field of the spec.
+	list<string> fields = split(b.workload, ":");
+	list<string>::iterator count_field = ++fields.begin();
+	uint64_t count;
+	convert_uint64_t(count, *count_field, "workload count");
+	*count_field = to_string((unsigned long long)(count * scale));
+
+	string spec;
+	for (list<string>::iterator it = fields.begin(); it != fields.end(); it++)
+		spec += ((it == fields.begin()) ? "" : ":") + *it;
+
+	Workload workload;
+	workload.Parse(spec);
+
+	SweepRun run(0, config, &workload, b.queue_depth);
+	run.sg_entry_size = b.sg_entry_size;
+	run.host_delay = HOST_DELAY;
+
+	// Only count what the simulation itself allocates.
+	allocations = 0;
+	allocated_bytes = 0;
+	run.Run();
+	uint64_t run_allocations = allocations;
+	uint64_t run_bytes = allocated_bytes;
+
+	struct rusage usage;
+	getrusage(RUSAGE_SELF, &usage);
+
+	uint64_t requests = run.reads + run.writes;
+	stringstream row;
+	row << "ok," << requests << "," << run.sim_cycles << "," << run.wall_seconds << ","
+		<< ((run.wall_seconds > 0) ? run.sim_cycles / run.wall_seconds : 0) << ","
+		<< ((run.wall_seconds > 0) ? requests / run.wall_seconds : 0) << ","
+		<< run_allocations << "," << run_bytes / 1e6 << "," << usage.ru_maxrss;
+	return row.str();
+}
+
+// Runs one benchmark in a child process, so a failure is reported as a row and every benchmark starts
+// with a fresh heap and RSS.
+string run_process(const Benchmark &b, Config config, uint64_t scale)
+{
+	string header = bench_header();
+	string failed = "failed" + string(count(header.begin(), header.end(), ',') - 2, ',');
+
+	int fds[2];
+	if (pipe(fds) != 0)
+	{
+		cerr << "ERROR: pipe() failed.\n";
+		abort();
+	}
+
+	cout.flush();
+	cerr.flush();
+	pid_t pid = fork();
+	if (pid < 0)
+	{
+		cerr << "ERROR: fork() failed.\n";
+		abort();
+	}
+	else if (pid == 0)
+	{
+		close(fds[0]);
+		string row = run_benchmark(b, config, scale);
+		ssize_t written = write(fds[1], row.c_str(), row.size());
+		_exit((written == (ssize_t)row.size()) ? 0 : 1);
+	}
+
+	close(fds[1]);
+	string row;
+	char buf[4096];
+	ssize_t n;
+	while ((n = read(fds[0], buf, sizeof(buf))) > 0)
+		row.append(buf, n);
+	close(fds[0]);
+
+	int status;
+	waitpid(pid, &status, 0);
+	if ((!WIFEXITED(status)) || (WEXITSTATUS(status) != 0) || (row.empty()))
+		row = failed;
+	return row;
+}
+
+void usage()
+{
+	cerr << "Usage: PCI_SSD_Bench [-l LABEL] [-c CONFIG] [-o CSV] [-s SCALE] [BENCHMARK ...]\n";
+	cerr << "Benchmarks:";
+	for (uint64_t i=0; i < NUM_BENCHMARKS; i++)
+		cerr << " " << SUITE[i].name;
+	cerr << "\n";
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	string label, config_file, output_file;
+	uint64_t scale = 1;
+	vector<const Benchmark *> selected;
+
+	for (int i=1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if ((arg == "-l") && (i+1 < argc))
+			label = argv[++i];
+		else if ((arg == "-c") && (i+1 < argc))
+			config_file = argv[++i];
+		else if ((arg == "-o") && (i+1 < argc))
+			output_file = argv[++i];
+		else if ((arg == "-s") && (i+1 < argc))
+			convert_uint64_t(scale, argv[++i], "-s");
+		else
+		{
+			uint64_t b = 0;
+			while ((b < NUM_BENCHMARKS) && (arg != SUITE[b].name))
+				b++;
+			if (b == NUM_BENCHMARKS)
+				usage();
+			selected.push_back(&SUITE[b]);
+		}
+	}
+
+	if (scale == 0)
+		usage();
+
+	if (selected.empty())
+	{
+		for (uint64_t b=0; b < NUM_BENCHMARKS; b++)
+			selected.push_back(&SUITE[b]);
+	}
+
+	Config config;
+	if (!config_file.empty())
+		config.Load(config_file);
+	config.Set("BACKEND_TYPE", "STUB");
+	config.Validate();
+
+	// Append to the output file, so it keeps the results of earlier commits.
+	ofstream out_file;
+	if (!output_file.empty())
+	{
+		ifstream existing(output_file.c_str());
+		bool is_new = (!existing.is_open()) || (existing.peek() == ifstream::traits_type::eof());
+		existing.close();
+
+		out_file.open(output_file.c_str(), ios_base::out | ios_base::app);
+		if (!out_file.is_open())
+		{
+			cerr << "ERROR: Failed to open " << output_file << "\n";
+			abort();
+		}
+		if (is_new)
+			out_file << bench_header() << "\n";
+	}
+	else
+		cout << bench_header() << "\n";
+	ostream &out = output_file.empty() ? cout : out_file;
+
+	for (uint64_t i=0; i < selected.size(); i++)
+	{
+		string row = run_process(*selected[i], config, scale);
+		out << label << "," << selected[i]->name << "," << row << "\n";
+		out.flush();
+		if (!output_file.empty())
+			cerr << "Bench: " << selected[i]->name << " " << row << "\n";
+	}
+
+	return 0;
+}
@@ -45,6 +45,7 @@ namespace PCISSD
 	class CallbackBase
 	{
 		public:
+		virtual ~CallbackBase() {}
 		virtual ReturnT operator()(Param1T, Param2T, Param3T) = 0;
 	};
 
@@ -0,0 +1,101 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+	void save_value(ostream &out, const string &value)
+	{
+		save_value(out, (uint64_t)value.size());
+		out.write(value.data(), value.size());
+	}
+
+	void restore_value(istream &in, string &value)
+	{
+		uint64_t size = 0;
+		restore_value(in, size);
+		value.clear();
+		if (!in.good())
+			return;
+
+		value.resize(size);
+		in.read(&value[0], size);
+	}
+
+	void save_value(ostream &out, const Transaction &t)
+	{
+		save_value(out, t.isWrite);
+		save_value(out, t.addr);
+		save_value(out, t.orig_addr);
+		save_value(out, t.num_sectors);
+		save_value(out, t.dma_sg_base);
+		save_value(out, t.dma_sg_len);
+		save_value(out, t.origin);
+		save_value(out, t.merged);
+		save_value(out, t.device);
+		save_value(out, t.parent_addr);
+		save_value(out, t.issue_time);
+		save_value(out, t.qos_class);
+	}
+
+	void restore_value(istream &in, Transaction &t)
+	{
+		restore_value(in, t.isWrite);
+		restore_value(in, t.addr);
+		restore_value(in, t.orig_addr);
+		restore_value(in, t.num_sectors);
+		restore_value(in, t.dma_sg_base);
+		restore_value(in, t.dma_sg_len);
+		restore_value(in, t.origin);
+		restore_value(in, t.merged);
+		restore_value(in, t.device);
+		restore_value(in, t.parent_addr);
+		restore_value(in, t.issue_time);
+		restore_value(in, t.qos_class);
+	}
+
+	void save_value(ostream &out, const TransactionEvent &e)
+	{
+		save_value(out, e.type);
+		save_value(out, e.trans);
+		save_value(out, e.expire_time);
+		save_value(out, e.layer);
+	}
+
+	void restore_value(istream &in, TransactionEvent &e)
+	{
+		restore_value(in, e.type);
+		restore_value(in, e.trans);
+		restore_value(in, e.expire_time);
+		restore_value(in, e.layer);
+	}
+}
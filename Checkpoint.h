@@ -0,0 +1,216 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_CHECKPOINT_H
+#define PCI_SSD_CHECKPOINT_H
+
+#include <algorithm>
+#include <map>
+#include <type_traits>
+#include <vector>
+
+#include "common.h"
+
+namespace PCISSD
+{
+	// Binary encoding used by the Save() and Restore() functions of the simulator objects.
+	// Scalars are written in host byte order and containers as a count followed by their elements,
+	// so a checkpoint can only be restored on the same kind of machine that wrote it.
+	// Restore functions replace the contents of their argument. Callers check the stream once at the end.
+
+	template <typename T> void save_value(ostream &out, const T &value);
+	template <typename T> void restore_value(istream &in, T &value);
+
+	void save_value(ostream &out, const string &value);
+	void restore_value(istream &in, string &value);
+	void save_value(ostream &out, const Transaction &t);
+	void restore_value(istream &in, Transaction &t);
+	void save_value(ostream &out, const TransactionEvent &e);
+	void restore_value(istream &in, TransactionEvent &e);
+
+	template <typename A, typename B> void save_value(ostream &out, const pair<A, B> &value);
+	template <typename A, typename B> void restore_value(istream &in, pair<A, B> &value);
+	template <typename T> void save_value(ostream &out, const list<T> &value);
+	template <typename T> void restore_value(istream &in, list<T> &value);
+	template <typename T> void save_value(ostream &out, const vector<T> &value);
+	template <typename T> void restore_value(istream &in, vector<T> &value);
+	template <typename T> void save_value(ostream &out, const set<T> &value);
+	template <typename T> void restore_value(istream &in, set<T> &value);
+	template <typename T> void save_value(ostream &out, const unordered_set<T> &value);
+	template <typename T> void restore_value(istream &in, unordered_set<T> &value);
+	template <typename K, typename V> void save_value(ostream &out, const unordered_map<K, V> &value);
+	template <typename K, typename V> void restore_value(istream &in, unordered_map<K, V> &value);
+	template <typename K, typename V> void save_value(ostream &out, const multimap<K, V> &value);
+	template <typename K, typename V> void restore_value(istream &in, multimap<K, V> &value);
+
+
+	template <typename T> void save_value(ostream &out, const T &value)
+	{
+		static_assert(is_arithmetic<T>::value || is_enum<T>::value, "save_value() needs an overload for this type");
+		out.write((const char *)&value, sizeof(T));
+	}
+
+	template <typename T> void restore_value(istream &in, T &value)
+	{
+		static_assert(is_arithmetic<T>::value || is_enum<T>::value, "restore_value() needs an overload for this type");
+		in.read((char *)&value, sizeof(T));
+	}
+
+	template <typename A, typename B> void save_value(ostream &out, const pair<A, B> &value)
+	{
+		save_value(out, value.first);
+		save_value(out, value.second);
+	}
+
+	template <typename A, typename B> void restore_value(istream &in, pair<A, B> &value)
+	{
+		restore_value(in, value.first);
+		restore_value(in, value.second);
+	}
+
+	// Every container is written the same way, so one pair of helpers does the work.
+	template <typename C> void save_container(ostream &out, const C &value)
+	{
+		save_value(out, (uint64_t)value.size());
+		for (typename C::const_iterator it = value.begin(); it != value.end(); it++)
+			save_value(out, *it);
+	}
+
+	template <typename T> void save_value(ostream &out, const list<T> &value) { save_container(out, value); }
+	template <typename T> void save_value(ostream &out, const vector<T> &value) { save_container(out, value); }
+	template <typename T> void save_value(ostream &out, const set<T> &value) { save_container(out, value); }
+	template <typename K, typename V> void save_value(ostream &out, const multimap<K, V> &value) { save_container(out, value); }
+
+	// Unordered containers are written in key order, so the same state always gives the same checkpoint.
+	template <typename T> void save_value(ostream &out, const unordered_set<T> &value)
+	{
+		vector<T> sorted(value.begin(), value.end());
+		sort(sorted.begin(), sorted.end());
+		save_container(out, sorted);
+	}
+
+	template <typename K, typename V> void save_value(ostream &out, const unordered_map<K, V> &value)
+	{
+		vector<K> keys;
+		for (typename unordered_map<K, V>::const_iterator it = value.begin(); it != value.end(); it++)
+			keys.push_back(it->first);
+		sort(keys.begin(), keys.end());
+
+		save_value(out, (uint64_t)keys.size());
+		for (uint64_t i=0; i < keys.size(); i++)
+		{
+			save_value(out, keys[i]);
+			save_value(out, value.find(keys[i])->second);
+		}
+	}
+
+	// Elements are read into a temporary and added at the end, which keeps the order of lists, vectors and
+	// multimap entries with equal keys. Nothing in the simulator depends on the iteration order of the unordered containers.
+	template <typename T> void restore_value(istream &in, list<T> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			T element;
+			restore_value(in, element);
+			value.push_back(element);
+		}
+	}
+
+	template <typename T> void restore_value(istream &in, vector<T> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			T element;
+			restore_value(in, element);
+			value.push_back(element);
+		}
+	}
+
+	template <typename T> void restore_value(istream &in, set<T> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			T element;
+			restore_value(in, element);
+			value.insert(value.end(), element);
+		}
+	}
+
+	template <typename T> void restore_value(istream &in, unordered_set<T> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			T element;
+			restore_value(in, element);
+			value.insert(element);
+		}
+	}
+
+	template <typename K, typename V> void restore_value(istream &in, unordered_map<K, V> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			pair<K, V> element;
+			restore_value(in, element);
+			value.insert(element);
+		}
+	}
+
+	template <typename K, typename V> void restore_value(istream &in, multimap<K, V> &value)
+	{
+		uint64_t count = 0;
+		restore_value(in, count);
+		value.clear();
+		for (uint64_t i=0; (i < count) && in.good(); i++)
+		{
+			pair<K, V> element;
+			restore_value(in, element);
+			value.insert(value.end(), element);
+		}
+	}
+}
+
+#endif
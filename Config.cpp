@@ -0,0 +1,428 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Config.h"
+#include "LinkModel.h"
+#include <algorithm>
+
+namespace PCISSD
+{
+	Config::Config()
+	{
+		// Defaults come from config.h.
+		internal_clock = INTERNAL_CLOCK;
+		external_clock = EXTERNAL_CLOCK;
+
+		backend_type = BACKEND_TYPE;
+		hybridsim_clock_1 = HYBRIDSIM_CLOCK_1;
+		hybridsim_clock_2 = HYBRIDSIM_CLOCK_2;
+		hybridsim_ini = HYBRIDSIM_INI;
+		flash_channels = FLASH_CHANNELS;
+		flash_dies_per_channel = FLASH_DIES_PER_CHANNEL;
+		flash_page_size = FLASH_PAGE_SIZE;
+		flash_pages_per_block = FLASH_PAGES_PER_BLOCK;
+		flash_read_delay = FLASH_READ_DELAY;
+		flash_program_delay = FLASH_PROGRAM_DELAY;
+		flash_erase_delay = FLASH_ERASE_DELAY;
+		flash_command_delay = FLASH_COMMAND_DELAY;
+		flash_channel_rate = FLASH_CHANNEL_RATE;
+		stub_delay = STUB_DELAY;
+
+		layer1_type = LAYER1_TYPE;
+		layer2_type = LAYER2_TYPE;
+		layer1_lanes = LAYER1_LANES;
+		layer2_lanes = LAYER2_LANES;
+		layer1_full_duplex = LAYER1_FULL_DUPLEX;
+		layer2_full_duplex = LAYER2_FULL_DUPLEX;
+		layer1_merge = LAYER1_MERGE;
+		layer2_merge = LAYER2_MERGE;
+		ncq_depth = NCQ_DEPTH;
+		sata_fis_overhead = SATA_FIS_OVERHEAD;
+		layer_scheduler = LAYER_SCHEDULER;
+		qos_weights = QOS_WEIGHTS;
+		qos_deadlines = QOS_DEADLINES;
+		scheduler_write_starvation = SCHEDULER_WRITE_STARVATION;
+		num_devices = NUM_DEVICES;
+		stripe_size = STRIPE_SIZE;
+		topology = TOPOLOGY;
+
+		pcie_max_payload = PCIE_MAX_PAYLOAD;
+		pcie_max_read_request = PCIE_MAX_READ_REQUEST;
+		pcie_read_completion_boundary = PCIE_READ_COMPLETION_BOUNDARY;
+		pcie_completion_coalescing = PCIE_COMPLETION_COALESCING;
+		pcie_tlp_header = PCIE_TLP_HEADER;
+		pcie_ack_factor = PCIE_ACK_FACTOR;
+		pcie_fc_update_factor = PCIE_FC_UPDATE_FACTOR;
+		pcie_flow_control = PCIE_FLOW_CONTROL;
+		pcie_posted_header_credits = PCIE_POSTED_HEADER_CREDITS;
+		pcie_posted_data_credits = PCIE_POSTED_DATA_CREDITS;
+		pcie_non_posted_header_credits = PCIE_NON_POSTED_HEADER_CREDITS;
+		pcie_non_posted_data_credits = PCIE_NON_POSTED_DATA_CREDITS;
+		pcie_completion_header_credits = PCIE_COMPLETION_HEADER_CREDITS;
+		pcie_completion_data_credits = PCIE_COMPLETION_DATA_CREDITS;
+		pcie_credit_return_delay = PCIE_CREDIT_RETURN_DELAY;
+		enable_aspm = ENABLE_ASPM;
+		aspm_l0s_entry = ASPM_L0S_ENTRY;
+		aspm_l0s_exit = ASPM_L0S_EXIT;
+		aspm_l1_entry = ASPM_L1_ENTRY;
+		aspm_l1_exit = ASPM_L1_EXIT;
+
+		enable_dma = ENABLE_DMA;
+		max_pending_dma = MAX_PENDING_DMA;
+
+		enable_cache = ENABLE_CACHE;
+		cache_size = CACHE_SIZE;
+		cache_ways = CACHE_WAYS;
+		cache_write_back = CACHE_WRITE_BACK;
+		cache_hit_delay = CACHE_HIT_DELAY;
+		cache_sector_delay = CACHE_SECTOR_DELAY;
+		cache_max_destage = CACHE_MAX_DESTAGE;
+		cache_destage_buffer = CACHE_DESTAGE_BUFFER;
+		cache_dirty_threshold = CACHE_DIRTY_THRESHOLD;
+
+		enable_prefetch = ENABLE_PREFETCH;
+		prefetch_streams = PREFETCH_STREAMS;
+		prefetch_threshold = PREFETCH_THRESHOLD;
+		prefetch_degree = PREFETCH_DEGREE;
+		prefetch_max_stride = PREFETCH_MAX_STRIDE;
+		prefetch_max_outstanding = PREFETCH_MAX_OUTSTANDING;
+		prefetch_buffer_size = PREFETCH_BUFFER_SIZE;
+
+		sample_period = SAMPLE_PERIOD;
+		sample_warmup = SAMPLE_WARMUP;
+		sample_window = SAMPLE_WINDOW;
+
+		stats_window = STATS_WINDOW;
+		steady_windows = STEADY_WINDOWS;
+		steady_threshold = STEADY_THRESHOLD;
+		stats_confidence = STATS_CONFIDENCE;
+		enable_profile = ENABLE_PROFILE;
+
+		// Register every setting under its config.h name.
+		Add_Param("INTERNAL_CLOCK", &Config::internal_clock);
+		Add_Param("EXTERNAL_CLOCK", &Config::external_clock);
+
+		Add_Param("BACKEND_TYPE", &Config::backend_type);
+		Add_Param("HYBRIDSIM_CLOCK_1", &Config::hybridsim_clock_1);
+		Add_Param("HYBRIDSIM_CLOCK_2", &Config::hybridsim_clock_2);
+		Add_Param("HYBRIDSIM_INI", &Config::hybridsim_ini);
+		Add_Param("FLASH_CHANNELS", &Config::flash_channels);
+		Add_Param("FLASH_DIES_PER_CHANNEL", &Config::flash_dies_per_channel);
+		Add_Param("FLASH_PAGE_SIZE", &Config::flash_page_size);
+		Add_Param("FLASH_PAGES_PER_BLOCK", &Config::flash_pages_per_block);
+		Add_Param("FLASH_READ_DELAY", &Config::flash_read_delay);
+		Add_Param("FLASH_PROGRAM_DELAY", &Config::flash_program_delay);
+		Add_Param("FLASH_ERASE_DELAY", &Config::flash_erase_delay);
+		Add_Param("FLASH_COMMAND_DELAY", &Config::flash_command_delay);
+		Add_Param("FLASH_CHANNEL_RATE", &Config::flash_channel_rate);
+		Add_Param("STUB_DELAY", &Config::stub_delay);
+
+		Add_Param("LAYER1_TYPE", &Config::layer1_type);
+		Add_Param("LAYER2_TYPE", &Config::layer2_type);
+		Add_Param("LAYER1_LANES", &Config::layer1_lanes);
+		Add_Param("LAYER2_LANES", &Config::layer2_lanes);
+		Add_Param("LAYER1_FULL_DUPLEX", &Config::layer1_full_duplex);
+		Add_Param("LAYER2_FULL_DUPLEX", &Config::layer2_full_duplex);
+		Add_Param("LAYER1_MERGE", &Config::layer1_merge);
+		Add_Param("LAYER2_MERGE", &Config::layer2_merge);
+		Add_Param("NCQ_DEPTH", &Config::ncq_depth);
+		Add_Param("SATA_FIS_OVERHEAD", &Config::sata_fis_overhead);
+		Add_Param("LAYER_SCHEDULER", &Config::layer_scheduler);
+		Add_Param("QOS_WEIGHTS", &Config::qos_weights);
+		Add_Param("QOS_DEADLINES", &Config::qos_deadlines);
+		Add_Param("SCHEDULER_WRITE_STARVATION", &Config::scheduler_write_starvation);
+		Add_Param("NUM_DEVICES", &Config::num_devices);
+		Add_Param("STRIPE_SIZE", &Config::stripe_size);
+		Add_Param("TOPOLOGY", &Config::topology);
+
+		Add_Param("PCIE_MAX_PAYLOAD", &Config::pcie_max_payload);
+		Add_Param("PCIE_MAX_READ_REQUEST", &Config::pcie_max_read_request);
+		Add_Param("PCIE_READ_COMPLETION_BOUNDARY", &Config::pcie_read_completion_boundary);
+		Add_Param("PCIE_COMPLETION_COALESCING", &Config::pcie_completion_coalescing);
+		Add_Param("PCIE_TLP_HEADER", &Config::pcie_tlp_header);
+		Add_Param("PCIE_ACK_FACTOR", &Config::pcie_ack_factor);
+		Add_Param("PCIE_FC_UPDATE_FACTOR", &Config::pcie_fc_update_factor);
+		Add_Param("PCIE_FLOW_CONTROL", &Config::pcie_flow_control);
+		Add_Param("PCIE_POSTED_HEADER_CREDITS", &Config::pcie_posted_header_credits);
+		Add_Param("PCIE_POSTED_DATA_CREDITS", &Config::pcie_posted_data_credits);
+		Add_Param("PCIE_NON_POSTED_HEADER_CREDITS", &Config::pcie_non_posted_header_credits);
+		Add_Param("PCIE_NON_POSTED_DATA_CREDITS", &Config::pcie_non_posted_data_credits);
+		Add_Param("PCIE_COMPLETION_HEADER_CREDITS", &Config::pcie_completion_header_credits);
+		Add_Param("PCIE_COMPLETION_DATA_CREDITS", &Config::pcie_completion_data_credits);
+		Add_Param("PCIE_CREDIT_RETURN_DELAY", &Config::pcie_credit_return_delay);
+		Add_Param("ENABLE_ASPM", &Config::enable_aspm);
+		Add_Param("ASPM_L0S_ENTRY", &Config::aspm_l0s_entry);
+		Add_Param("ASPM_L0S_EXIT", &Config::aspm_l0s_exit);
+		Add_Param("ASPM_L1_ENTRY", &Config::aspm_l1_entry);
+		Add_Param("ASPM_L1_EXIT", &Config::aspm_l1_exit);
+
+		Add_Param("ENABLE_DMA", &Config::enable_dma);
+		Add_Param("MAX_PENDING_DMA", &Config::max_pending_dma);
+
+		Add_Param("ENABLE_CACHE", &Config::enable_cache);
+		Add_Param("CACHE_SIZE", &Config::cache_size);
+		Add_Param("CACHE_WAYS", &Config::cache_ways);
+		Add_Param("CACHE_WRITE_BACK", &Config::cache_write_back);
+		Add_Param("CACHE_HIT_DELAY", &Config::cache_hit_delay);
+		Add_Param("CACHE_SECTOR_DELAY", &Config::cache_sector_delay);
+		Add_Param("CACHE_MAX_DESTAGE", &Config::cache_max_destage);
+		Add_Param("CACHE_DESTAGE_BUFFER", &Config::cache_destage_buffer);
+		Add_Param("CACHE_DIRTY_THRESHOLD", &Config::cache_dirty_threshold);
+
+		Add_Param("ENABLE_PREFETCH", &Config::enable_prefetch);
+		Add_Param("PREFETCH_STREAMS", &Config::prefetch_streams);
+		Add_Param("PREFETCH_THRESHOLD", &Config::prefetch_threshold);
+		Add_Param("PREFETCH_DEGREE", &Config::prefetch_degree);
+		Add_Param("PREFETCH_MAX_STRIDE", &Config::prefetch_max_stride);
+		Add_Param("PREFETCH_MAX_OUTSTANDING", &Config::prefetch_max_outstanding);
+		Add_Param("PREFETCH_BUFFER_SIZE", &Config::prefetch_buffer_size);
+
+		Add_Param("SAMPLE_PERIOD", &Config::sample_period);
+		Add_Param("SAMPLE_WARMUP", &Config::sample_warmup);
+		Add_Param("SAMPLE_WINDOW", &Config::sample_window);
+
+		Add_Param("STATS_WINDOW", &Config::stats_window);
+		Add_Param("STEADY_WINDOWS", &Config::steady_windows);
+		Add_Param("STEADY_THRESHOLD", &Config::steady_threshold);
+		Add_Param("STATS_CONFIDENCE", &Config::stats_confidence);
+		Add_Param("ENABLE_PROFILE", &Config::enable_profile);
+	}
+
+	void Config::Add_Param(string key, uint64_t Config::*value)
+	{
+		keys.push_back(key);
+		uint_params[key] = value;
+	}
+
+	void Config::Add_Param(string key, bool Config::*value)
+	{
+		keys.push_back(key);
+		bool_params[key] = value;
+	}
+
+	void Config::Add_Param(string key, string Config::*value)
+	{
+		keys.push_back(key);
+		string_params[key] = value;
+	}
+
+	void Config::Load(string ini_file)
+	{
+		ifstream inFile;
+		inFile.open(ini_file.c_str(), ifstream::in);
+		if (!inFile.is_open())
+		{
+			cerr << "ERROR: Failed to open PCI_SSD config file " << ini_file << "\n";
+			abort();
+		}
+
+		string line;
+		while (getline(inFile, line))
+		{
+			// Filter comments out.
+			size_t pos = line.find("#");
+			line = strip(line.substr(0, pos));
+			if (line.empty())
+				continue;
+
+			list<string> split_line = split(line, "=", 2);
+			if (split_line.size() != 2)
+			{
+				cerr << "ERROR: Invalid line in PCI_SSD config file " << ini_file << ": " << line << "\n";
+				abort();
+			}
+
+			Set(strip(split_line.front()), strip(split_line.back()));
+		}
+
+		inFile.close();
+	}
+
+	void Config::Set(string key, string value)
+	{
+		// Allow the names of interface and backend types as well as their numbers.
+		if ((key == "LAYER1_TYPE") || (key == "LAYER2_TYPE"))
+		{
+			if ((value.size() > 0) && (!isdigit(value[0])))
+				value = to_string((unsigned long long)interface_type(value));
+		}
+		else if (key == "BACKEND_TYPE")
+		{
+			if (value == "HYBRIDSIM")
+				value = to_string((unsigned long long)BACKEND_HYBRIDSIM);
+			else if (value == "FLASH")
+				value = to_string((unsigned long long)BACKEND_FLASH);
+			else if (value == "STUB")
+				value = to_string((unsigned long long)BACKEND_STUB);
+		}
+		else if (key == "LAYER_SCHEDULER")
+		{
+			if (value == "FIFO")
+				value = to_string((unsigned long long)SCHEDULER_FIFO);
+			else if (value == "PRIORITY")
+				value = to_string((unsigned long long)SCHEDULER_PRIORITY);
+			else if (value == "WFQ")
+				value = to_string((unsigned long long)SCHEDULER_WFQ);
+			else if (value == "READ_FIRST")
+				value = to_string((unsigned long long)SCHEDULER_READ_FIRST);
+			else if (value == "DEADLINE")
+				value = to_string((unsigned long long)SCHEDULER_DEADLINE);
+		}
+
+		if (uint_params.count(key) == 1)
+		{
+			convert_uint64_t(this->*uint_params[key], value, key);
+		}
+		else if (bool_params.count(key) == 1)
+		{
+			uint64_t tmp;
+			convert_uint64_t(tmp, value, key);
+			if (tmp > 1)
+			{
+				cerr << "ERROR: PCI_SSD setting " << key << " must be 0 or 1 (got " << value << ")\n";
+				abort();
+			}
+			this->*bool_params[key] = (tmp == 1);
+		}
+		else if (string_params.count(key) == 1)
+		{
+			// Allow strings to be quoted, since TOPOLOGY usually has spaces in it.
+			if ((value.size() >= 2) && (value[0] == '"') && (value[value.size()-1] == '"'))
+				value = value.substr(1, value.size()-2);
+			this->*string_params[key] = value;
+		}
+		else
+		{
+			cerr << "ERROR: Unknown PCI_SSD setting " << key << "\n";
+			abort();
+		}
+	}
+
+	void Config::Validate()
+	{
+		string fail_reason;
+		vector<uint64_t> weights, deadlines;
+
+		if ((internal_clock == 0) || (external_clock == 0) || (hybridsim_clock_1 == 0) || (hybridsim_clock_2 == 0))
+			fail_reason = "clock ratios must be nonzero";
+		else if ((backend_type != BACKEND_HYBRIDSIM) && (backend_type != BACKEND_FLASH) && (backend_type != BACKEND_STUB))
+			fail_reason = "BACKEND_TYPE must be HYBRIDSIM, FLASH or STUB";
+#ifdef NO_HYBRIDSIM
+		else if (backend_type == BACKEND_HYBRIDSIM)
+			fail_reason = "PCI_SSD was built without HybridSim, so BACKEND_TYPE must be FLASH or STUB";
+#endif
+		else if ((flash_channels == 0) || (flash_dies_per_channel == 0) || (flash_pages_per_block == 0) || (flash_channel_rate == 0))
+			fail_reason = "flash geometry and channel rate must be nonzero";
+		else if ((flash_page_size == 0) || (flash_page_size % SECTOR_SIZE != 0))
+			fail_reason = "FLASH_PAGE_SIZE must be a multiple of SECTOR_SIZE";
+		else if ((layer1_type > PCI6) || (layer2_type > PCI6))
+			fail_reason = "unknown layer interface type";
+		else if ((layer1_lanes == 0) || (layer1_lanes > 16) || ((layer1_lanes & (layer1_lanes - 1)) != 0))
+			fail_reason = "LAYER1_LANES must be 1, 2, 4, 8 or 16";
+		else if ((layer2_lanes == 0) || (layer2_lanes > 16) || ((layer2_lanes & (layer2_lanes - 1)) != 0))
+			fail_reason = "LAYER2_LANES must be 1, 2, 4, 8 or 16";
+		else if (ncq_depth > 32)
+			fail_reason = "NCQ_DEPTH must be at most 32 (the number of SATA tags)";
+		else if (layer_scheduler > SCHEDULER_DEADLINE)
+			fail_reason = "LAYER_SCHEDULER must be FIFO, PRIORITY, WFQ, READ_FIRST or DEADLINE";
+		else if ((!Parse_Class_List(qos_weights, weights)) || (count(weights.begin(), weights.end(), 0) != 0))
+			fail_reason = "QOS_WEIGHTS must have a nonzero weight for each of the NUM_QOS_CLASSES classes";
+		else if (!Parse_Class_List(qos_deadlines, deadlines))
+			fail_reason = "QOS_DEADLINES must have a deadline for each of the NUM_QOS_CLASSES classes";
+		else if (num_devices == 0)
+			fail_reason = "NUM_DEVICES must be at least 1";
+		else if ((stripe_size == 0) || (stripe_size % SECTOR_SIZE != 0))
+			fail_reason = "STRIPE_SIZE must be a multiple of SECTOR_SIZE";
+		else if ((pcie_max_payload < 128) || (pcie_max_payload > 4096) || ((pcie_max_payload & (pcie_max_payload - 1)) != 0))
+			fail_reason = "PCIE_MAX_PAYLOAD must be a power of two from 128 to 4096";
+		else if ((pcie_max_read_request < 128) || (pcie_max_read_request > 4096) || ((pcie_max_read_request & (pcie_max_read_request - 1)) != 0))
+			fail_reason = "PCIE_MAX_READ_REQUEST must be a power of two from 128 to 4096";
+		else if ((pcie_read_completion_boundary != 64) && (pcie_read_completion_boundary != 128))
+			fail_reason = "PCIE_READ_COMPLETION_BOUNDARY must be 64 or 128";
+		else if ((pcie_ack_factor == 0) || (pcie_fc_update_factor == 0))
+			fail_reason = "PCIE_ACK_FACTOR and PCIE_FC_UPDATE_FACTOR must be nonzero";
+		else if (max_pending_dma == 0)
+			fail_reason = "MAX_PENDING_DMA must be nonzero";
+		else if ((enable_cache) && ((cache_ways == 0) || (cache_size < cache_ways * SECTOR_SIZE) || (cache_max_destage == 0)))
+			fail_reason = "CACHE_SIZE must hold at least one set, and CACHE_WAYS and CACHE_MAX_DESTAGE must be nonzero";
+		else if ((enable_cache) && (cache_destage_buffer < MAX_SECTORS))
+			fail_reason = "CACHE_DESTAGE_BUFFER must hold at least MAX_SECTORS sectors";
+		else if ((enable_cache) && (cache_dirty_threshold > 100))
+			fail_reason = "CACHE_DIRTY_THRESHOLD is a percentage";
+		else if ((enable_prefetch) && ((prefetch_streams == 0) || (prefetch_threshold == 0)))
+			fail_reason = "PREFETCH_STREAMS and PREFETCH_THRESHOLD must be nonzero";
+		else if ((sample_period != 0) && ((sample_window == 0) || (sample_warmup + sample_window >= sample_period)))
+			fail_reason = "SAMPLE_WINDOW must be nonzero, and SAMPLE_WARMUP + SAMPLE_WINDOW less than SAMPLE_PERIOD";
+		else if ((stats_window == 0) || (steady_windows < 2))
+			fail_reason = "STATS_WINDOW must be nonzero and STEADY_WINDOWS at least 2";
+
+		if (!fail_reason.empty())
+		{
+			cerr << "ERROR: Invalid PCI_SSD configuration: " << fail_reason << "\n";
+			abort();
+		}
+	}
+
+	bool Config::Parse_Class_List(string value, vector<uint64_t> &values)
+	{
+		values.clear();
+
+		list<string> fields = split(strip(value));
+		for (list<string>::iterator it = fields.begin(); it != fields.end(); it++)
+		{
+			if (it->empty())
+				continue;
+			if (it->find_first_not_of("0123456789") != string::npos)
+				return false;
+
+			uint64_t v;
+			convert_uint64_t(v, *it, "QoS class list");
+			values.push_back(v);
+		}
+
+		return values.size() == NUM_QOS_CLASSES;
+	}
+
+	void Config::Print(ostream &out)
+	{
+		for (list<string>::iterator it = keys.begin(); it != keys.end(); it++)
+		{
+			out << *it << "=";
+			if (uint_params.count(*it) == 1)
+				out << this->*uint_params[*it];
+			else if (bool_params.count(*it) == 1)
+				out << this->*bool_params[*it];
+			else
+				out << "\"" << this->*string_params[*it] << "\"";
+			out << "\n";
+		}
+	}
+}
@@ -0,0 +1,172 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_CONFIG_CLASS_H
+#define PCI_SSD_CONFIG_CLASS_H
+
+#include <vector>
+
+#include "common.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	// Run-time settings for one PCI_SSD_System.
+	// Every setting starts at the default from config.h and can be changed by loading an ini file of
+	// KEY=VALUE lines (keys are the config.h names, # starts a comment) or by calling Set() directly.
+	// Interface types can be given by name (PCI3) and BACKEND_TYPE as HYBRIDSIM, FLASH or STUB, and LAYER_SCHEDULER by name (WFQ).
+	// DEBUG and DEBUG_FILE stay compile-time, and so does everything under "should never change" in config.h.
+	class Config
+	{
+		public:
+		Config();
+
+		void Load(string ini_file);
+		void Set(string key, string value);
+		void Validate();
+		void Print(ostream &out);
+
+		// Read a space separated list with one number per QoS class (QOS_WEIGHTS, QOS_DEADLINES).
+		// Returns false if it doesn't have exactly NUM_QOS_CLASSES numbers.
+		static bool Parse_Class_List(string value, vector<uint64_t> &values);
+
+		// Internal functions
+		void Add_Param(string key, uint64_t Config::*value);
+		void Add_Param(string key, bool Config::*value);
+		void Add_Param(string key, string Config::*value);
+
+
+		// Clocks
+		uint64_t internal_clock;
+		uint64_t external_clock;
+
+		// Backend
+		uint64_t backend_type;
+		uint64_t hybridsim_clock_1;
+		uint64_t hybridsim_clock_2;
+		string hybridsim_ini;
+		uint64_t flash_channels;
+		uint64_t flash_dies_per_channel;
+		uint64_t flash_page_size;
+		uint64_t flash_pages_per_block;
+		uint64_t flash_read_delay;
+		uint64_t flash_program_delay;
+		uint64_t flash_erase_delay;
+		uint64_t flash_command_delay;
+		uint64_t flash_channel_rate;
+		uint64_t stub_delay;
+
+		// Interconnect
+		uint64_t layer1_type;
+		uint64_t layer2_type;
+		uint64_t layer1_lanes;
+		uint64_t layer2_lanes;
+		bool layer1_full_duplex;
+		bool layer2_full_duplex;
+		bool layer1_merge;
+		bool layer2_merge;
+		uint64_t ncq_depth;
+		uint64_t sata_fis_overhead;
+		uint64_t layer_scheduler;
+		string qos_weights;
+		string qos_deadlines;
+		uint64_t scheduler_write_starvation;
+		uint64_t num_devices;
+		uint64_t stripe_size;
+		string topology;
+
+		// PCIe link model
+		uint64_t pcie_max_payload;
+		uint64_t pcie_max_read_request;
+		uint64_t pcie_read_completion_boundary;
+		bool pcie_completion_coalescing;
+		uint64_t pcie_tlp_header;
+		uint64_t pcie_ack_factor;
+		uint64_t pcie_fc_update_factor;
+		bool pcie_flow_control;
+		uint64_t pcie_posted_header_credits;
+		uint64_t pcie_posted_data_credits;
+		uint64_t pcie_non_posted_header_credits;
+		uint64_t pcie_non_posted_data_credits;
+		uint64_t pcie_completion_header_credits;
+		uint64_t pcie_completion_data_credits;
+		uint64_t pcie_credit_return_delay;
+		bool enable_aspm;
+		uint64_t aspm_l0s_entry;
+		uint64_t aspm_l0s_exit;
+		uint64_t aspm_l1_entry;
+		uint64_t aspm_l1_exit;
+
+		// DMA
+		bool enable_dma;
+		uint64_t max_pending_dma;
+
+		// Controller cache
+		bool enable_cache;
+		uint64_t cache_size;
+		uint64_t cache_ways;
+		bool cache_write_back;
+		uint64_t cache_hit_delay;
+		uint64_t cache_sector_delay;
+		uint64_t cache_max_destage;
+		uint64_t cache_destage_buffer;
+		uint64_t cache_dirty_threshold;
+
+		// Stream prefetcher
+		bool enable_prefetch;
+		uint64_t prefetch_streams;
+		uint64_t prefetch_threshold;
+		uint64_t prefetch_degree;
+		uint64_t prefetch_max_stride;
+		uint64_t prefetch_max_outstanding;
+		uint64_t prefetch_buffer_size;
+
+		// Sampled simulation
+		uint64_t sample_period;
+		uint64_t sample_warmup;
+		uint64_t sample_window;
+
+		// Statistics
+		uint64_t stats_window;
+		uint64_t steady_windows;
+		uint64_t steady_threshold;
+		uint64_t stats_confidence;
+		bool enable_profile;
+
+		// Lookup tables for Set() and Print(). These hold member pointers so that copies of a Config stay valid.
+		list<string> keys; // In the order they appear in config.h.
+		unordered_map<string, uint64_t Config::*> uint_params;
+		unordered_map<string, bool Config::*> bool_params;
+		unordered_map<string, string Config::*> string_params;
+	};
+}
+
+#endif
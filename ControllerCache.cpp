@@ -0,0 +1,523 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#include "ControllerCache.h"
+#include "PCI_SSD_System.h"
+#include "SSD_Device.h"
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+
+	ControllerCache::ControllerCache(PCI_SSD_System *parent, SSD_Device *device, uint64_t size, uint64_t ways, bool write_back, uint64_t hit_delay, 
+			uint64_t sector_delay, uint64_t max_destage, uint64_t destage_buffer_size, uint64_t dirty_threshold)
+	{
+		assert(parent != NULL);
+		assert(device != NULL);
+		assert(ways > 0);
+		assert(size >= ways * SECTOR_SIZE);
+		assert(max_destage > 0);
+
+		this->parent = parent;
+		this->device = device;
+		this->num_sets = size / (ways * SECTOR_SIZE);
+		this->ways = ways;
+		this->write_back = write_back;
+		this->hit_delay = hit_delay;
+		this->sector_delay = sector_delay;
+		this->max_destage = max_destage;
+		this->destage_buffer_size = destage_buffer_size;
+		this->dirty_threshold = dirty_threshold;
+
+		sets.resize(num_sets);
+		dirty_count = 0;
+		destage_outstanding = 0;
+
+		lines_version = 0;
+
+		read_hits = 0;
+		read_misses = 0;
+		write_hits = 0;
+		write_misses = 0;
+		evictions = 0;
+		dirty_evictions = 0;
+		destages = 0;
+		background_destages = 0;
+	}
+
+	void ControllerCache::update()
+	{
+		// Evicted dirty sectors go first, since the destage buffer is the only place they live.
+		while ((destage_outstanding < max_destage) && (!evict_queue.empty()))
+		{
+			uint64_t sector = evict_queue.front();
+
+			// Skip sectors that were written again and brought back into the cache.
+			if (evicted_dirty.count(sector) == 0)
+			{
+				evict_queue.pop_front();
+				continue;
+			}
+
+			// Wait for any other access to this sector to leave the backend.
+			if (device->Backend_Sector_Busy(sector))
+				break;
+
+			evict_queue.pop_front();
+			evicted_dirty.erase(sector);
+			destage_inflight.insert(sector);
+			Issue_Destage(sector);
+		}
+
+		// Drain the oldest dirty lines in the background once there are too many of them.
+		uint64_t num_lines = num_sets * ways;
+		while ((destage_outstanding < max_destage) && (dirty_count * 100 > dirty_threshold * num_lines) && (!dirty_order.empty()))
+		{
+			uint64_t sector = dirty_order.front();
+
+			// Skip lines that were evicted or cleaned since they became dirty.
+			if ((lines.count(sector) == 0) || (!lines[sector]))
+			{
+				dirty_order.pop_front();
+				continue;
+			}
+
+			if (device->Backend_Sector_Busy(sector))
+				break;
+
+			dirty_order.pop_front();
+
+			// The line is clean as of now. If it is written during the destage it just becomes dirty again.
+			lines[sector] = false;
+			lines_version++;
+			dirty_count--;
+			background_destages++;
+			Issue_Destage(sector);
+		}
+	}
+
+	void ControllerCache::Access(Transaction t)
+	{
+		// Write-back writes need room in the destage buffer for the dirty lines they will evict.
+		if (t.isWrite && write_back && (!Destage_Room(t)))
+		{
+			if (DEBUG)
+			{
+				(parent->debug_file) << parent->currentClockCycle << " : Destage buffer full, retrying cache write: (" 
+						<< t.isWrite << ", " << t.addr << ")\n";
+				parent->debug_file.flush();
+			}
+
+			parent->Retry_Event(TransactionEvent(CONTROLLER_RETRY_EVENT, t, parent->currentClockCycle));
+			return;
+		}
+
+		bool hit = true;
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			if (!Present(t.addr + i * SECTOR_SIZE))
+				hit = false;
+		}
+
+		if (t.isWrite && write_back)
+		{
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+				Fill(t.addr + i * SECTOR_SIZE, true);
+
+			if (hit)
+				write_hits++;
+			else
+				write_misses++;
+		}
+		else if (t.isWrite)
+		{
+			// Write-through. The cache is updated when the backend finishes the write.
+			// Like a read miss, it is only counted once the backend takes it.
+			if (device->Backend_Access(t))
+			{
+				if (hit)
+					write_hits++;
+				else
+					write_misses++;
+			}
+			return;
+		}
+		else if (hit)
+		{
+			// Update LRU order for the sectors that are still in the cache.
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+			{
+				uint64_t cur_sector = t.addr + i * SECTOR_SIZE;
+				if (lines.count(cur_sector) == 1)
+					Fill(cur_sector, lines[cur_sector]);
+			}
+
+			read_hits++;
+		}
+		else
+		{
+			// Read miss. Backend_Done() fills the cache when the backend returns. The miss is counted here, since
+			// a read the prefetch buffer serves never reaches Backend_Done(). A read that has to retry comes back
+			// through Access(), so it is only counted once the backend or the prefetch buffer takes it.
+			if (device->Backend_Access(t))
+				read_misses++;
+			return;
+		}
+
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Cache hit for transaction: (" << t.isWrite << ", " << t.addr << ")\n";
+			parent->debug_file.flush();
+		}
+
+		uint64_t delay = hit_delay + sector_delay * t.num_sectors;
+		TransactionEvent e (CACHE_HIT_EVENT, t, parent->currentClockCycle + delay);
+		parent->Add_Event(e);
+	}
+
+	void ControllerCache::Backend_Done(Transaction t)
+	{
+		// A read miss or a write-through write finished, so bring its sectors into the cache.
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+			Fill(t.addr + i * SECTOR_SIZE, false);
+	}
+
+	void ControllerCache::Destage_Done(Transaction t)
+	{
+		assert(t.origin == DESTAGE_TRANSACTION);
+		assert(destage_outstanding > 0);
+
+		destage_outstanding--;
+		destages++;
+
+		destage_inflight.erase(t.addr);
+
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Finished destage for sector " << t.addr << "\n";
+			parent->debug_file.flush();
+		}
+	}
+
+	void ControllerCache::Functional_Access(Transaction t)
+	{
+		bool hit = true;
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			if (!Present(t.addr + i * SECTOR_SIZE))
+				hit = false;
+		}
+
+		if (t.isWrite)
+		{
+			if (hit)
+				write_hits++;
+			else
+				write_misses++;
+
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+				Fill(t.addr + i * SECTOR_SIZE, write_back);
+
+			if (!write_back)
+				device->backend->Functional_Access(true, t.addr, (uint64_t)t.num_sectors * SECTOR_SIZE);
+		}
+		else if (hit)
+		{
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+			{
+				uint64_t cur_sector = t.addr + i * SECTOR_SIZE;
+				if (lines.count(cur_sector) == 1)
+					Fill(cur_sector, lines[cur_sector]);
+			}
+
+			read_hits++;
+		}
+		else
+		{
+			// Misses that the prefetch buffer serves are not brought into the cache, just like in detailed mode.
+			read_misses++;
+			if (!device->Functional_Backend_Access(t))
+				Backend_Done(t);
+		}
+
+		Functional_Destage();
+	}
+
+	// Write out what the destage engine would have, without the backend timing. Destages already in the
+	// backend are left to finish on their own.
+	void ControllerCache::Functional_Destage()
+	{
+		while (!evict_queue.empty())
+		{
+			uint64_t sector = evict_queue.front();
+			evict_queue.pop_front();
+
+			if (evicted_dirty.count(sector) == 0)
+				continue;
+
+			evicted_dirty.erase(sector);
+			device->backend->Functional_Access(true, sector, SECTOR_SIZE);
+		}
+
+		uint64_t num_lines = num_sets * ways;
+		while ((dirty_count * 100 > dirty_threshold * num_lines) && (!dirty_order.empty()))
+		{
+			uint64_t sector = dirty_order.front();
+			dirty_order.pop_front();
+
+			if ((lines.count(sector) == 0) || (!lines[sector]))
+				continue;
+
+			lines[sector] = false;
+			dirty_count--;
+			device->backend->Functional_Access(true, sector, SECTOR_SIZE);
+		}
+	}
+
+	void ControllerCache::Print_Stats(ostream &out)
+	{
+		uint64_t reads = read_hits + read_misses;
+		uint64_t writes = write_hits + write_misses;
+		double read_hit_rate = reads ? (double)read_hits / (double)reads : 0.0;
+		double write_hit_rate = writes ? (double)write_hits / (double)writes : 0.0;
+
+		out << "PCI_SSD controller cache (" << (write_back ? "write-back" : "write-through") << ", " 
+				<< num_sets << " sets, " << ways << " ways)\n";
+		out << "\treads: " << reads << " (hits: " << read_hits << ", misses: " << read_misses 
+				<< ", hit rate: " << read_hit_rate << ")\n";
+		out << "\twrites: " << writes << " (hits: " << write_hits << ", misses: " << write_misses 
+				<< ", hit rate: " << write_hit_rate << ")\n";
+		out << "\tevictions: " << evictions << " (dirty: " << dirty_evictions << ")\n";
+		out << "\tdestages: " << destages << " (background: " << background_destages << ")\n";
+		out << "\tdirty lines: " << dirty_count << "\n";
+	}
+
+	bool ControllerCache::Present(uint64_t sector)
+	{
+		return (lines.count(sector) != 0) || (evicted_dirty.count(sector) != 0) || (destage_inflight.count(sector) != 0);
+	}
+
+	void ControllerCache::Fill(uint64_t sector, bool dirty)
+	{
+		lines_version++;
+
+		// An evicted copy that has not reached the backend is still newer than what the backend has.
+		if (evicted_dirty.count(sector) != 0)
+		{
+			evicted_dirty.erase(sector);
+			dirty = true;
+		}
+
+		uint64_t set_index = Set_Index(sector);
+		list<uint64_t> &cur_set = sets[set_index];
+
+		if (lines.count(sector) != 0)
+		{
+			// Already in the cache, so just move it to the front of the LRU order.
+			cur_set.remove(sector);
+			cur_set.push_front(sector);
+
+			if (dirty && !lines[sector])
+			{
+				lines[sector] = true;
+				dirty_count++;
+				dirty_order.push_back(sector);
+			}
+			return;
+		}
+
+		if (cur_set.size() == ways)
+		{
+			// Don't let clean fills push dirty lines into a full destage buffer. Just skip the allocation.
+			if ((!dirty) && lines[cur_set.back()] && (evicted_dirty.size() >= destage_buffer_size))
+				return;
+
+			Evict(set_index);
+		}
+
+		cur_set.push_front(sector);
+		lines[sector] = dirty;
+		if (dirty)
+		{
+			dirty_count++;
+			dirty_order.push_back(sector);
+		}
+	}
+
+	bool ControllerCache::Destage_Room(Transaction t)
+	{
+		// Each sector evicts at most one line.
+		if (evicted_dirty.size() + t.num_sectors <= destage_buffer_size)
+		{
+			eviction_counts.erase(t.addr);
+			return true;
+		}
+
+		// Counting the evictions is slow, so a retrying write keeps its count until the buffer has drained
+		// enough for it, and then counts again if the lines have changed in the meantime.
+		// Only one access per sector is in the controller at a time, so the address identifies the write.
+		if (eviction_counts.count(t.addr) == 0)
+			eviction_counts[t.addr] = make_pair(lines_version, Dirty_Evictions(t));
+		pair<uint64_t, uint64_t> &count = eviction_counts[t.addr];
+		if (evicted_dirty.size() + count.second > destage_buffer_size)
+			return false;
+		if (count.first != lines_version)
+			count = make_pair(lines_version, Dirty_Evictions(t));
+		if (evicted_dirty.size() + count.second > destage_buffer_size)
+			return false;
+
+		eviction_counts.erase(t.addr);
+		return true;
+	}
+
+	// Number of dirty lines that filling the sectors of a write would push into the destage buffer.
+	// Replays Fill() on copies of the sets the write touches.
+	uint64_t ControllerCache::Dirty_Evictions(Transaction t)
+	{
+		unordered_map<uint64_t, list<uint64_t>> touched;
+		unordered_set<uint64_t> filled; // Sectors of this write in the cache so far.
+		unordered_set<uint64_t> evicted; // Lines this write has evicted so far.
+		uint64_t dirty = 0;
+
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			uint64_t sector = t.addr + i * SECTOR_SIZE;
+			uint64_t set_index = Set_Index(sector);
+			if (touched.count(set_index) == 0)
+				touched[set_index] = sets[set_index];
+			list<uint64_t> &cur_set = touched[set_index];
+
+			if ((filled.count(sector) != 0) || ((lines.count(sector) != 0) && (evicted.count(sector) == 0)))
+			{
+				cur_set.remove(sector);
+			}
+			else if (cur_set.size() == ways)
+			{
+				// Lines this write filled earlier are dirty too.
+				uint64_t victim = cur_set.back();
+				cur_set.pop_back();
+				if ((filled.count(victim) != 0) || lines[victim])
+					dirty++;
+				filled.erase(victim);
+				evicted.insert(victim);
+			}
+
+			cur_set.push_front(sector);
+			filled.insert(sector);
+		}
+
+		return dirty;
+	}
+
+	void ControllerCache::Evict(uint64_t set_index)
+	{
+		list<uint64_t> &cur_set = sets[set_index];
+		assert(!cur_set.empty());
+
+		uint64_t victim = cur_set.back();
+		cur_set.pop_back();
+		evictions++;
+
+		assert(lines.count(victim) == 1);
+		if (lines[victim])
+		{
+			// Dirty data moves to the destage buffer until the destage engine writes it out.
+			dirty_count--;
+			dirty_evictions++;
+			evicted_dirty.insert(victim);
+			evict_queue.push_back(victim);
+		}
+		lines.erase(victim);
+	}
+
+	void ControllerCache::Issue_Destage(uint64_t sector)
+	{
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Starting destage for sector " << sector << "\n";
+			parent->debug_file.flush();
+		}
+
+		list<uint64_t> empty;
+		Transaction t(true, sector, sector, 1, empty, empty, DESTAGE_TRANSACTION);
+		t.device = device->id;
+		destage_outstanding++;
+		device->handle_backend_add_transaction(t);
+	}
+
+	uint64_t ControllerCache::Set_Index(uint64_t sector)
+	{
+		return (sector / SECTOR_SIZE) % num_sets;
+	}
+
+	void ControllerCache::Save(ostream &out)
+	{
+		save_value(out, sets);
+		save_value(out, lines);
+		save_value(out, dirty_count);
+		save_value(out, dirty_order);
+		save_value(out, evict_queue);
+		save_value(out, evicted_dirty);
+		save_value(out, destage_inflight);
+		save_value(out, destage_outstanding);
+		save_value(out, read_hits);
+		save_value(out, read_misses);
+		save_value(out, write_hits);
+		save_value(out, write_misses);
+		save_value(out, evictions);
+		save_value(out, dirty_evictions);
+		save_value(out, destages);
+		save_value(out, background_destages);
+		save_value(out, lines_version);
+		save_value(out, eviction_counts);
+	}
+
+	void ControllerCache::Restore(istream &in)
+	{
+		restore_value(in, sets);
+		restore_value(in, lines);
+		restore_value(in, dirty_count);
+		restore_value(in, dirty_order);
+		restore_value(in, evict_queue);
+		restore_value(in, evicted_dirty);
+		restore_value(in, destage_inflight);
+		restore_value(in, destage_outstanding);
+		restore_value(in, read_hits);
+		restore_value(in, read_misses);
+		restore_value(in, write_hits);
+		restore_value(in, write_misses);
+		restore_value(in, evictions);
+		restore_value(in, dirty_evictions);
+		restore_value(in, destages);
+		restore_value(in, background_destages);
+		restore_value(in, lines_version);
+		restore_value(in, eviction_counts);
+	}
+}
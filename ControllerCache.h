@@ -0,0 +1,108 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PCI_SSD_CONTROLLERCACHE_H
+#define PCI_SSD_CONTROLLERCACHE_H
+
+#include "common.h"
+
+namespace PCISSD
+{
+	// Forward declare.
+	class PCI_SSD_System;
+	class SSD_Device;
+
+	// Set associative DRAM cache on the SSD controller.
+	// It sits between Layer 2 and the backend and is managed at sector granularity.
+	class ControllerCache
+	{
+		public:
+		ControllerCache(PCI_SSD_System *parent, SSD_Device *device, uint64_t size, uint64_t ways, bool write_back, uint64_t hit_delay, 
+				uint64_t sector_delay, uint64_t max_destage, uint64_t destage_buffer_size, uint64_t dirty_threshold);
+
+		void update();
+		void Access(Transaction t);
+		void Backend_Done(Transaction t);
+		void Destage_Done(Transaction t);
+		void Functional_Access(Transaction t);
+		void Print_Stats(ostream &out);
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Internal functions
+		bool Present(uint64_t sector);
+		void Fill(uint64_t sector, bool dirty);
+		bool Destage_Room(Transaction t); // Returns true if the destage buffer has room for the dirty lines a write evicts.
+		uint64_t Dirty_Evictions(Transaction t);
+		void Evict(uint64_t set_index);
+		void Issue_Destage(uint64_t sector);
+		void Functional_Destage();
+		uint64_t Set_Index(uint64_t sector);
+
+
+		// Parameters
+		PCI_SSD_System *parent;
+		SSD_Device *device;
+		uint64_t num_sets;
+		uint64_t ways;
+		bool write_back;
+		uint64_t hit_delay;
+		uint64_t sector_delay;
+		uint64_t max_destage;
+		uint64_t destage_buffer_size;
+		uint64_t dirty_threshold;
+
+		// Internal state
+		vector<list<uint64_t>> sets; // Sectors in each set in LRU order (front is most recently used).
+		unordered_map<uint64_t, bool> lines; // Dirty bit for every sector in the cache.
+		uint64_t dirty_count;
+
+		list<uint64_t> dirty_order; // Order in which lines became dirty. Stale entries are skipped.
+		list<uint64_t> evict_queue; // Evicted dirty sectors waiting for a destage.
+		unordered_set<uint64_t> evicted_dirty; // Evicted dirty sectors waiting in the destage buffer.
+		unordered_set<uint64_t> destage_inflight; // Evicted dirty sectors with a destage in the backend.
+		uint64_t destage_outstanding;
+
+		uint64_t lines_version; // Bumped whenever a line is filled, moved or cleaned.
+		unordered_map<uint64_t, pair<uint64_t, uint64_t>> eviction_counts; // Retrying write -> (lines_version, Dirty_Evictions()).
+
+		// Stats
+		uint64_t read_hits;
+		uint64_t read_misses;
+		uint64_t write_hits;
+		uint64_t write_misses;
+		uint64_t evictions;
+		uint64_t dirty_evictions;
+		uint64_t destages;
+		uint64_t background_destages;
+	};
+}
+
+#endif
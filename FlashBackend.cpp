@@ -0,0 +1,265 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#include "FlashBackend.h"
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+	static void save_value(ostream &out, const FlashRequest &r)
+	{
+		save_value(out, r.isWrite);
+		save_value(out, r.addr);
+		save_value(out, r.size);
+		save_value(out, r.arrival_time);
+	}
+
+	static void restore_value(istream &in, FlashRequest &r)
+	{
+		restore_value(in, r.isWrite);
+		restore_value(in, r.addr);
+		restore_value(in, r.size);
+		restore_value(in, r.arrival_time);
+	}
+
+	FlashBackend::FlashBackend(uint id, uint64_t channels, uint64_t dies_per_channel, uint64_t page_size, uint64_t pages_per_block,
+			uint64_t read_delay, uint64_t program_delay, uint64_t erase_delay, uint64_t command_delay, uint64_t channel_rate)
+	{
+		assert(channels > 0);
+		assert(dies_per_channel > 0);
+		assert(page_size > 0);
+		assert(pages_per_block > 0);
+		assert(channel_rate > 0);
+
+		this->systemID = id;
+		this->channels = channels;
+		this->dies_per_channel = dies_per_channel;
+		this->num_dies = channels * dies_per_channel;
+		this->page_size = page_size;
+		this->pages_per_block = pages_per_block;
+		this->read_delay = read_delay;
+		this->program_delay = program_delay;
+		this->erase_delay = erase_delay;
+		this->command_delay = command_delay;
+		this->channel_rate = channel_rate;
+
+		ReadDone = NULL;
+		WriteDone = NULL;
+		currentClockCycle = 0;
+
+		die_queues.resize(num_dies);
+		die_busy_until.resize(num_dies, 0);
+		die_programs.resize(num_dies, 0);
+		channel_busy_until.resize(channels, 0);
+		next_write_die = 0;
+
+		reads = 0;
+		writes = 0;
+		erases = 0;
+		total_read_latency = 0;
+		total_write_latency = 0;
+	}
+
+	bool FlashBackend::addTransaction(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		// Requests must stay within one page.
+		uint64_t page = addr / page_size;
+		assert(size > 0);
+		assert((addr + size - 1) / page_size == page);
+
+		uint64_t die = isWrite ? Map_Write(page) : Map_Read(page);
+		die_queues[die].push_back(FlashRequest(isWrite, addr, size, currentClockCycle));
+
+		return true;
+	}
+
+	void FlashBackend::update()
+	{
+		// Start the next request on every idle die.
+		for (uint64_t die=0; die < num_dies; die++)
+		{
+			if ((die_busy_until[die] <= currentClockCycle) && (!die_queues[die].empty()))
+				Start_Request(die);
+		}
+
+		// Issue callbacks for everything that has finished.
+		while ((!completions.empty()) && (completions.begin()->first <= currentClockCycle))
+		{
+			FlashRequest r = completions.begin()->second;
+			completions.erase(completions.begin());
+
+			BackendCompleteCB *cb = r.isWrite ? WriteDone : ReadDone;
+			if (cb != NULL)
+				(*cb)(systemID, r.addr, currentClockCycle);
+		}
+
+		currentClockCycle++;
+	}
+
+	void FlashBackend::RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone)
+	{
+		ReadDone = readDone;
+		WriteDone = writeDone;
+	}
+
+	void FlashBackend::printLogfile(ostream &out)
+	{
+		double avg_read = reads ? (double)total_read_latency / (double)reads : 0.0;
+		double avg_write = writes ? (double)total_write_latency / (double)writes : 0.0;
+
+		out << "PCI_SSD flash backend (" << channels << " channels, " << dies_per_channel << " dies per channel)\n";
+		out << "\treads: " << reads << " (average latency: " << avg_read << " ns)\n";
+		out << "\twrites: " << writes << " (average latency: " << avg_write << " ns)\n";
+		out << "\terases: " << erases << "\n";
+	}
+
+	uint64_t FlashBackend::Max_Request_Size()
+	{
+		return page_size;
+	}
+
+	void FlashBackend::Functional_Access(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		// Reads leave nothing behind. Writes move their pages and use up the open blocks, just like addTransaction().
+		if (!isWrite)
+			return;
+
+		assert(size > 0);
+		for (uint64_t page = addr / page_size; page <= (addr + size - 1) / page_size; page++)
+		{
+			uint64_t die = Map_Write(page);
+			die_programs[die]++;
+			if (die_programs[die] == pages_per_block)
+				die_programs[die] = 0;
+		}
+	}
+
+	void FlashBackend::Save(ostream &out)
+	{
+		save_value(out, currentClockCycle);
+		save_value(out, die_queues);
+		save_value(out, die_busy_until);
+		save_value(out, die_programs);
+		save_value(out, channel_busy_until);
+		save_value(out, page_map);
+		save_value(out, next_write_die);
+		save_value(out, completions);
+		save_value(out, reads);
+		save_value(out, writes);
+		save_value(out, erases);
+		save_value(out, total_read_latency);
+		save_value(out, total_write_latency);
+	}
+
+	void FlashBackend::Restore(istream &in)
+	{
+		restore_value(in, currentClockCycle);
+		restore_value(in, die_queues);
+		restore_value(in, die_busy_until);
+		restore_value(in, die_programs);
+		restore_value(in, channel_busy_until);
+		restore_value(in, page_map);
+		restore_value(in, next_write_die);
+		restore_value(in, completions);
+		restore_value(in, reads);
+		restore_value(in, writes);
+		restore_value(in, erases);
+		restore_value(in, total_read_latency);
+		restore_value(in, total_write_latency);
+	}
+
+	uint64_t FlashBackend::Map_Read(uint64_t page)
+	{
+		// Pages that were never written are striped statically across the dies.
+		if (page_map.count(page) == 0)
+			return page % num_dies;
+		return page_map[page];
+	}
+
+	uint64_t FlashBackend::Map_Write(uint64_t page)
+	{
+		// Writes go to the next die in round-robin order, regardless of where the page was before.
+		uint64_t die = next_write_die;
+		next_write_die = (next_write_die + 1) % num_dies;
+		page_map[page] = die;
+		return die;
+	}
+
+	void FlashBackend::Start_Request(uint64_t die)
+	{
+		FlashRequest r = die_queues[die].front();
+		die_queues[die].pop_front();
+
+		uint64_t channel = die % channels;
+		uint64_t transfer = Channel_Delay(r.size);
+		uint64_t start = currentClockCycle + command_delay;
+		uint64_t done;
+
+		if (r.isWrite)
+		{
+			// Move the data to the die, then program it.
+			uint64_t transfer_start = max(start, channel_busy_until[channel]);
+			channel_busy_until[channel] = transfer_start + transfer;
+			done = transfer_start + transfer + program_delay;
+
+			// Erase a block once the die has filled one.
+			die_programs[die]++;
+			if (die_programs[die] == pages_per_block)
+			{
+				die_programs[die] = 0;
+				die_busy_until[die] = done + erase_delay;
+				erases++;
+			}
+			else
+				die_busy_until[die] = done;
+
+			writes++;
+			total_write_latency += done - r.arrival_time;
+		}
+		else
+		{
+			// Sense the page, then move the data out over the channel.
+			uint64_t transfer_start = max(start + read_delay, channel_busy_until[channel]);
+			channel_busy_until[channel] = transfer_start + transfer;
+			done = transfer_start + transfer;
+			die_busy_until[die] = done;
+
+			reads++;
+			total_read_latency += done - r.arrival_time;
+		}
+
+		completions.insert(make_pair(done, r));
+	}
+
+	uint64_t FlashBackend::Channel_Delay(uint64_t num_bytes)
+	{
+		return (num_bytes * 1000000000 + channel_rate - 1) / channel_rate;
+	}
+}
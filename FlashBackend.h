@@ -0,0 +1,123 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PCI_SSD_FLASHBACKEND_H
+#define PCI_SSD_FLASHBACKEND_H
+
+#include <map>
+
+#include "Backend.h"
+
+namespace PCISSD
+{
+	class FlashRequest
+	{
+		public:
+		bool isWrite;
+		uint64_t addr;
+		uint64_t size;
+		uint64_t arrival_time;
+
+		FlashRequest() {}
+
+		FlashRequest(bool w, uint64_t a, uint64_t s, uint64_t t)
+		{
+			isWrite = w;
+			addr = a;
+			size = s;
+			arrival_time = t;
+		}
+	};
+
+	// Analytic NAND flash model.
+	// Each die serves its own FIFO queue. Reads take tR on the die and then move the data over the
+	// channel. Writes move the data over the channel and then take tPROG on the die. Channels are shared
+	// by their dies, so transfers are serialized per channel. Written pages are placed round-robin across
+	// all dies (log-structured), and every FLASH_PAGES_PER_BLOCK programs on a die cost one erase.
+	class FlashBackend : public Backend
+	{
+		public:
+		FlashBackend(uint id, uint64_t channels, uint64_t dies_per_channel, uint64_t page_size, uint64_t pages_per_block,
+				uint64_t read_delay, uint64_t program_delay, uint64_t erase_delay, uint64_t command_delay, uint64_t channel_rate);
+
+		bool addTransaction(bool isWrite, uint64_t addr, uint64_t size);
+		void update();
+		void RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone);
+		void printLogfile(ostream &out);
+		uint64_t Max_Request_Size();
+		void Functional_Access(bool isWrite, uint64_t addr, uint64_t size);
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Internal functions
+		uint64_t Map_Read(uint64_t page);
+		uint64_t Map_Write(uint64_t page);
+		void Start_Request(uint64_t die);
+		uint64_t Channel_Delay(uint64_t num_bytes);
+
+
+		// Parameters
+		uint systemID;
+		uint64_t channels;
+		uint64_t dies_per_channel;
+		uint64_t num_dies;
+		uint64_t page_size;
+		uint64_t pages_per_block;
+		uint64_t read_delay;
+		uint64_t program_delay;
+		uint64_t erase_delay;
+		uint64_t command_delay;
+		uint64_t channel_rate;
+
+		// Internal state
+		BackendCompleteCB *ReadDone;
+		BackendCompleteCB *WriteDone;
+		uint64_t currentClockCycle;
+
+		vector<list<FlashRequest>> die_queues;
+		vector<uint64_t> die_busy_until;
+		vector<uint64_t> die_programs; // Programs since the last erase on each die.
+		vector<uint64_t> channel_busy_until;
+
+		unordered_map<uint64_t, uint64_t> page_map; // Die holding each logical page that has been written.
+		uint64_t next_write_die;
+
+		multimap<uint64_t, FlashRequest> completions; // Requests in flight, keyed by completion time.
+
+		// Stats
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t erases;
+		uint64_t total_read_latency;
+		uint64_t total_write_latency;
+	};
+}
+
+#endif
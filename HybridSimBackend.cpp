@@ -0,0 +1,112 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#include "HybridSimBackend.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	HybridSimBackend::HybridSimBackend(uint id, string ini)
+	{
+		hybridsim = HybridSim::getMemorySystemInstance(id, ini);
+
+		ReadDone = NULL;
+		WriteDone = NULL;
+
+		// Register callbacks to HybridSim.
+		typedef HybridSim::Callback <HybridSimBackend, void, uint, uint64_t, uint64_t> hybridsim_callback_t;
+		HybridSim::TransactionCompleteCB *read_cb = new hybridsim_callback_t(this, &HybridSimBackend::HybridSim_Read_Callback);
+		HybridSim::TransactionCompleteCB *write_cb = new hybridsim_callback_t(this, &HybridSimBackend::HybridSim_Write_Callback);
+		hybridsim->RegisterCallbacks(read_cb, write_cb);
+	}
+
+	HybridSimBackend::~HybridSimBackend()
+	{
+		delete hybridsim;
+	}
+
+	bool HybridSimBackend::addTransaction(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		assert(size == HYBRIDSIM_TRANSACTION_SIZE);
+		return hybridsim->addTransaction(isWrite, addr);
+	}
+
+	void HybridSimBackend::update()
+	{
+		hybridsim->update();
+	}
+
+	void HybridSimBackend::RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone)
+	{
+		ReadDone = readDone;
+		WriteDone = writeDone;
+	}
+
+	void HybridSimBackend::printLogfile(ostream &out)
+	{
+		// HybridSim writes its stats to its own log files.
+		hybridsim->printLogfile();
+	}
+
+	uint64_t HybridSimBackend::Max_Request_Size()
+	{
+		return HYBRIDSIM_TRANSACTION_SIZE;
+	}
+
+	void HybridSimBackend::Functional_Access(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		// HybridSim has no functional interface, so its state is only warmed by the detailed windows.
+	}
+
+	void HybridSimBackend::Save(ostream &out)
+	{
+		// HybridSim has no way to export its internal state.
+		cerr << "ERROR: Checkpoints are not supported with the HybridSim backend. Use BACKEND_FLASH instead.\n";
+		abort();
+	}
+
+	void HybridSimBackend::Restore(istream &in)
+	{
+		cerr << "ERROR: Checkpoints are not supported with the HybridSim backend. Use BACKEND_FLASH instead.\n";
+		abort();
+	}
+
+	void HybridSimBackend::HybridSim_Read_Callback(uint id, uint64_t addr, uint64_t cycle)
+	{
+		if (ReadDone != NULL)
+			(*ReadDone)(id, addr, cycle);
+	}
+
+	void HybridSimBackend::HybridSim_Write_Callback(uint id, uint64_t addr, uint64_t cycle)
+	{
+		if (WriteDone != NULL)
+			(*WriteDone)(id, addr, cycle);
+	}
+}
@@ -0,0 +1,69 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PCI_SSD_HYBRIDSIMBACKEND_H
+#define PCI_SSD_HYBRIDSIMBACKEND_H
+
+#include "Backend.h"
+
+// External Interface for HybridSim
+#include <HybridSim.h>
+
+namespace PCISSD
+{
+	// Adapter for HybridSim. HybridSim only takes HYBRIDSIM_TRANSACTION_SIZE byte accesses,
+	// so this backend reports that as its largest request size.
+	class HybridSimBackend : public Backend
+	{
+		public:
+		HybridSimBackend(uint id, string ini);
+		~HybridSimBackend();
+
+		bool addTransaction(bool isWrite, uint64_t addr, uint64_t size);
+		void update();
+		void RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone);
+		void printLogfile(ostream &out);
+		uint64_t Max_Request_Size();
+		void Functional_Access(bool isWrite, uint64_t addr, uint64_t size);
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Internal functions
+		void HybridSim_Read_Callback(uint id, uint64_t addr, uint64_t cycle);
+		void HybridSim_Write_Callback(uint id, uint64_t addr, uint64_t cycle);
+
+		// Internal state
+		HybridSim::HybridSystem *hybridsim;
+		BackendCompleteCB *ReadDone;
+		BackendCompleteCB *WriteDone;
+	};
+}
+
+#endif
@@ -1,29 +1,115 @@
 #include "Layer.h"
 #include "PCI_SSD_System.h"
+#include "Checkpoint.h"
 
 namespace PCISSD
 {
+	static void save_value(ostream &out, const CreditSet &c)
+	{
+		for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+		{
+			save_value(out, c.header[i]);
+			save_value(out, c.data[i]);
+		}
+	}
 
-	Layer::Layer(PCI_SSD_System *parent, uint64_t data_delay, uint64_t command_delay, uint64_t num_lanes, bool full_duplex,
-			TransactionEventType send_event_type, TransactionEventType return_event_type, string layer_name)
+	static void restore_value(istream &in, CreditSet &c)
+	{
+		for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+		{
+			restore_value(in, c.header[i]);
+			restore_value(in, c.data[i]);
+		}
+	}
+
+	static void save_value(ostream &out, const CreditReturn &c)
+	{
+		save_value(out, c.time);
+		save_value(out, c.down);
+		save_value(out, c.up);
+	}
+
+	static void restore_value(istream &in, CreditReturn &c)
+	{
+		restore_value(in, c.time);
+		restore_value(in, c.down);
+		restore_value(in, c.up);
+	}
+
+
+	Layer::Layer(PCI_SSD_System *parent, uint id, LinkModel *link, bool full_duplex, bool merge, string layer_name)
 	{
 		assert(parent != NULL);
+		assert(link != NULL);
 
 		this->parent = parent;
-		this->data_delay = data_delay;
-		this->command_delay = command_delay;
-		this->num_lanes = num_lanes;
+		this->id = id;
+		this->link = link;
 		this->full_duplex = full_duplex;
-		this->send_event_type = send_event_type;
-		this->return_event_type = return_event_type;
+		this->merge = merge;
 		this->layer_name = layer_name;
 
 		send_busy = false;
 		return_busy = false;
+		send_remainder = 0;
+		return_remainder = 0;
+
+		// Both receivers advertise the same credits.
+		const Config &config = parent->config;
+		flow_control = config.pcie_flow_control && link->pcie;
+		credit_return_delay = config.pcie_credit_return_delay;
+		credit_limit.header[POSTED_CREDIT] = config.pcie_posted_header_credits;
+		credit_limit.data[POSTED_CREDIT] = config.pcie_posted_data_credits;
+		credit_limit.header[NON_POSTED_CREDIT] = config.pcie_non_posted_header_credits;
+		credit_limit.data[NON_POSTED_CREDIT] = config.pcie_non_posted_data_credits;
+		credit_limit.header[COMPLETION_CREDIT] = config.pcie_completion_header_credits;
+		credit_limit.data[COMPLETION_CREDIT] = config.pcie_completion_data_credits;
+		down_credits = credit_limit;
+		up_credits = credit_limit;
+
+		vector<uint64_t> weights, deadlines;
+		Config::Parse_Class_List(config.qos_weights, weights);
+		Config::Parse_Class_List(config.qos_deadlines, deadlines);
+		send_scheduler = new Scheduler(config.layer_scheduler, weights, deadlines, config.scheduler_write_starvation);
+		return_scheduler = new Scheduler(config.layer_scheduler, weights, deadlines, config.scheduler_write_starvation);
+
+		ncq = link->sata && (config.ncq_depth != 0);
+		ncq_depth = config.ncq_depth;
+		send_data_phase = false;
+
+		aspm = config.enable_aspm && link->pcie;
+		l0s_entry = config.aspm_l0s_entry;
+		l0s_exit = config.aspm_l0s_exit;
+		l1_entry = config.aspm_l1_entry;
+		l1_exit = config.aspm_l1_exit;
+		idle_since = 0;
+		ready_time = 0;
+
+		merged_transactions = 0;
+		send_credit_stalls = 0;
+		return_credit_stalls = 0;
+		tag_stalls = 0;
+		peak_tags = 0;
+		l0s_cycles = 0;
+		l1_cycles = 0;
+		l0s_exits = 0;
+		l1_exits = 0;
+		exit_cycles = 0;
+	}
+
+	Layer::~Layer()
+	{
+		delete link;
+		delete send_scheduler;
+		delete return_scheduler;
 	}
 
 	void Layer::update()
 	{
+		// Give back any credits that have made it back to the sender.
+		if (flow_control)
+			Release_Credits();
+
 		// If we are in half_duplex mode, then we are busy for both send and return
 		// if either path is busy.
 		bool half_duplex_busy = (!full_duplex) && (send_busy || return_busy);
@@ -34,12 +120,17 @@ namespace PCISSD
 		{
 			if (!return_queue.empty())
 			{
-				// Extract the transaction at the front of the queue.
-				Transaction t = return_queue.front();
-				return_queue.pop_front();
+				// Extract the transaction the scheduler picks once the receiver has room for it.
+				list<Transaction>::iterator it = return_scheduler->Pick(return_queue);
+				Transaction t = *it;
+				if (Reserve_Credits(t, "RETURN"))
+				{
+					return_queue.erase(it);
+					return_scheduler->Served(t, return_queue);
 
-				// Put this transaction in the event queue with appropriate delay as timer.
-				Return_Event_Start(t);
+					// Put this transaction in the event queue with appropriate delay as timer.
+					Return_Event_Start(t);
+				}
 			}
 		}
 
@@ -47,18 +138,66 @@ namespace PCISSD
 		half_duplex_busy = (!full_duplex) && (send_busy || return_busy);
 
 		// Check send queue
+		// With NCQ, the data phases of writes already at the device go ahead of new commands.
 		if (!(half_duplex_busy || send_busy))
 		{
-			if (!send_queue.empty())
+			if (!data_queue.empty())
 			{
-				// Extract the transaction at the front of the queue.
-				Transaction t = send_queue.front();
-				send_queue.pop_front();
+				Transaction t = data_queue.front();
+				data_queue.pop_front();
 
-				// Put this transaction in the event queue with appropriate delay as timer.
+				send_data_phase = true;
 				Send_Event_Start(t);
 			}
+			else if (!send_queue.empty())
+			{
+				if (!Start_Send_Transaction())
+					tag_stalls++;
+			}
+		}
+	}
+
+	bool Layer::Start_Send_Transaction()
+	{
+		// A new command needs a free tag.
+		if ((ncq) && (ncq_tags.size() >= ncq_depth))
+			return false;
+
+		// Extract the transaction the scheduler picks.
+		list<Transaction>::iterator it = send_scheduler->Pick(send_queue);
+		Transaction t = *it;
+		send_queue.erase(it);
+
+		// Pull any contiguous requests out of the queue and send them along with this one.
+		if (merge)
+			t = Merge_Send_Transaction(t);
+
+		if (!Reserve_Credits(t, "SEND"))
+		{
+			// Wait at the head of the queue for the receiver to return credits.
+			send_queue.push_front(t);
+			return true;
+		}
+		send_scheduler->Served(t, send_queue);
+
+		if (ncq)
+		{
+			assert(ncq_tags.count(make_pair(t.device, t.addr)) == 0);
+			ncq_tags.insert(make_pair(t.device, t.addr));
+			peak_tags = max(peak_tags, (uint64_t)ncq_tags.size());
 		}
+
+		// Put this transaction in the event queue with appropriate delay as timer.
+		Send_Event_Start(t);
+		return true;
+	}
+
+	void Layer::Release_Tag(Transaction t)
+	{
+		// Links below this one may have merged commands that each took a tag here.
+		ncq_tags.erase(make_pair(t.device, t.addr));
+		for (list<Transaction>::iterator it = t.merged.begin(); it != t.merged.end(); it++)
+			ncq_tags.erase(make_pair(it->device, it->addr));
 	}
 
 	void Layer::Add_Send_Transaction(Transaction t)
@@ -87,21 +226,40 @@ namespace PCISSD
 
 	void Layer::Send_Event_Start(Transaction t)
 	{
-		Event_Start(t, data_delay, command_delay, send_event_type, "SEND");
+		// Write data goes down with the command. The device fetches it with DMA reads, so it comes back as completions.
+		// With NCQ, the command goes down on its own and the write data follows in a separate data phase.
+		// Its DMA Setup FIS actually goes up, but it is counted here since it always comes just before the data.
+		uint64_t ps;
+		if (ncq)
+			ps = send_data_phase ? link->FIS_Data_Time(t.num_sectors * SECTOR_SIZE) : link->FIS_Command_Time();
+		else
+			ps = t.isWrite ? link->Data_Time(t.num_sectors * SECTOR_SIZE, true) : link->Command_Time();
+		uint64_t delay = To_Cycles(ps, send_remainder) + Credit_Delay(t, "SEND");
+		Event_Start(t, delay, LAYER_SEND_EVENT, "SEND");
 	}
 
 	void Layer::Return_Event_Start(Transaction t)
 	{
-		Event_Start(t, command_delay, data_delay, return_event_type, "RETURN");
+		// Read data comes back up with the completion. The device writes it to host memory with posted writes.
+		// With NCQ, read data goes up in a data phase, and then a Set Device Bits FIS completes the command.
+		uint64_t ps;
+		if (ncq)
+			ps = (t.isWrite ? 0 : link->FIS_Data_Time(t.num_sectors * SECTOR_SIZE)) + link->FIS_Status_Time();
+		else
+			ps = t.isWrite ? link->Command_Time() : link->Data_Time(t.num_sectors * SECTOR_SIZE, false);
+		uint64_t delay = To_Cycles(ps, return_remainder) + Credit_Delay(t, "RETURN");
+		Event_Start(t, delay, LAYER_RETURN_EVENT, "RETURN");
 	}
 
-	void Layer::Event_Start(Transaction t, uint64_t write_delay, uint64_t read_delay, TransactionEventType event_type, string type)
+	void Layer::Event_Start(Transaction t, uint64_t delay, TransactionEventType event_type, string type)
 	{
+		// Wait for the link to come out of any low power state.
+		if (aspm)
+			delay += Wake_Link();
+
 		// Add event to the event queue.
-		uint64_t delay = t.isWrite ? write_delay : read_delay;
-		delay = delay * t.num_sectors; 
-		delay = delay / num_lanes;
 		TransactionEvent e (event_type, t, parent->currentClockCycle + delay);
+		e.layer = id;
 		parent->Add_Event(e);
 
 		// Set the appropriate busy flag.
@@ -119,15 +277,37 @@ namespace PCISSD
 
 	}
 
-	void Layer::Send_Event_Done(Transaction t)
+	uint64_t Layer::To_Cycles(uint64_t ps, uint64_t &remainder)
+	{
+		// The internal clock is 1 GHz. Rather than rounding every transfer up to a whole cycle,
+		// keep the leftover picoseconds and add them to the next transfer in the same direction.
+		ps += remainder;
+		remainder = ps % 1000;
+		return ps / 1000;
+	}
+
+	bool Layer::Send_Event_Done(Transaction t)
 	{
 		Event_Done(t, "SEND");
+
+		// With NCQ, a write waits at the device for its data phase.
+		if ((ncq) && (t.isWrite) && (!send_data_phase))
+		{
+			data_queue.push_back(t);
+			return false;
+		}
+
+		send_data_phase = false;
+		return true;
 	}
 
 
 	void Layer::Return_Event_Done(Transaction t)
 	{
 		Event_Done(t, "RETURN");
+
+		if (ncq)
+			Release_Tag(t);
 	}
 
 	void Layer::Event_Done(Transaction t, string type)
@@ -138,6 +318,18 @@ namespace PCISSD
 		else
 			return_busy = false;
 
+		// Start the idle timer once nothing is in flight in either direction.
+		if ((!send_busy) && (!return_busy))
+			idle_since = parent->currentClockCycle;
+
+		// The receiver hands the credits back once it has processed the transfer.
+		if (flow_control)
+		{
+			CreditReturn r = (type == "SEND") ? send_credits : return_credits;
+			r.time = parent->currentClockCycle + credit_return_delay;
+			credit_returns.push_back(r);
+		}
+
 		if (DEBUG)
 		{
 			(parent->debug_file) << parent->currentClockCycle << " : Finished " << layer_name << " " << type << 
@@ -145,5 +337,354 @@ namespace PCISSD
 			parent->debug_file.flush();
 		}
 	}
-}
 
+	Transaction Layer::Merge_Send_Transaction(Transaction t)
+	{
+		Transaction m = t;
+		m.merged.clear();
+		m.dma_sg_base.clear();
+		m.dma_sg_len.clear();
+
+		// Keep track of the original transactions so they can be completed separately.
+		list<Transaction> parts;
+		if (t.merged.empty())
+			parts.push_back(t);
+		else
+			parts = t.merged;
+
+		// Scan the queue like an elevator, extending the transaction in either direction until nothing else fits.
+		bool found = true;
+		while (found)
+		{
+			found = false;
+			for (list<Transaction>::iterator it = send_queue.begin(); it != send_queue.end(); it++)
+			{
+				if ((it->isWrite != m.isWrite) || (it->origin != HOST_TRANSACTION) || (m.origin != HOST_TRANSACTION))
+					continue;
+				if (it->qos_class != m.qos_class)
+					continue;
+				// Below the stripe point addresses are local to a device, so neighbours on other devices aren't adjacent.
+				if (it->device != m.device)
+					continue;
+				if (m.num_sectors + it->num_sectors > MAX_SECTORS)
+					continue;
+
+				uint64_t m_end = m.addr + m.num_sectors * SECTOR_SIZE;
+				uint64_t it_end = it->addr + it->num_sectors * SECTOR_SIZE;
+				if ((it->addr != m_end) && (it_end != m.addr))
+					continue;
+
+				if (DEBUG)
+				{
+					(parent->debug_file) << parent->currentClockCycle << " : Merging transaction (" << it->isWrite << ", " << it->addr 
+							<< ") into " << layer_name << " send for (" << m.isWrite << ", " << m.addr << ")\n";
+					parent->debug_file.flush();
+				}
+
+				if (it_end == m.addr)
+				{
+					m.addr = it->addr;
+					m.orig_addr = it->addr;
+				}
+				m.num_sectors += it->num_sectors;
+
+				if (it->merged.empty())
+					parts.push_back(*it);
+				else
+					parts.insert(parts.end(), it->merged.begin(), it->merged.end());
+
+				send_queue.erase(it);
+				merged_transactions++;
+				found = true;
+				break;
+			}
+		}
+
+		if (parts.size() == 1)
+			return t;
+
+		m.merged = parts;
+		return m;
+	}
+
+	void Layer::Credits_Needed(Transaction t, string type, CreditSet &down, CreditSet &up)
+	{
+		uint64_t num_bytes = t.num_sectors * SECTOR_SIZE;
+
+		if (type == "SEND")
+		{
+			// The command is a posted write to the device.
+			down.header[POSTED_CREDIT] += link->Posted_TLPs(COMMAND_SIZE);
+			down.data[POSTED_CREDIT] += (COMMAND_SIZE + 15) / 16;
+
+			// Write data is fetched by the device. Its read requests go up and the completions come down.
+			if (t.isWrite)
+			{
+				up.header[NON_POSTED_CREDIT] += link->Read_Requests(num_bytes);
+				down.header[COMPLETION_CREDIT] += link->Completion_TLPs(num_bytes);
+				down.data[COMPLETION_CREDIT] += (num_bytes + 15) / 16;
+			}
+		}
+		else
+		{
+			// The completion is a posted write to the host.
+			up.header[POSTED_CREDIT] += link->Posted_TLPs(COMMAND_SIZE);
+			up.data[POSTED_CREDIT] += (COMMAND_SIZE + 15) / 16;
+
+			// Read data is written to host memory.
+			if (!t.isWrite)
+			{
+				up.header[POSTED_CREDIT] += link->Posted_TLPs(num_bytes);
+				up.data[POSTED_CREDIT] += (num_bytes + 15) / 16;
+			}
+		}
+	}
+
+	bool Layer::Reserve_Credits(Transaction t, string type)
+	{
+		if (!flow_control)
+			return true;
+
+		CreditSet need_down, need_up;
+		Credits_Needed(t, type, need_down, need_up);
+
+		// Check both receivers before taking anything.
+		CreditSet down = down_credits;
+		CreditSet up = up_credits;
+		CreditReturn taken;
+		if ((!Take_Credits(need_down, down, taken.down)) || (!Take_Credits(need_up, up, taken.up)))
+		{
+			if (type == "SEND")
+				send_credit_stalls++;
+			else
+				return_credit_stalls++;
+			return false;
+		}
+
+		down_credits = down;
+		up_credits = up;
+		if (type == "SEND")
+			send_credits = taken;
+		else
+			return_credits = taken;
+		return true;
+	}
+
+	bool Layer::Take_Credits(CreditSet &need, CreditSet &available, CreditSet &taken)
+	{
+		for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+		{
+			// A transfer never holds more than the receiver advertises. The rest streams through behind it.
+			if (credit_limit.header[i] != 0)
+			{
+				taken.header[i] = min(need.header[i], credit_limit.header[i]);
+				if (available.header[i] < taken.header[i])
+					return false;
+				available.header[i] -= taken.header[i];
+			}
+			if (credit_limit.data[i] != 0)
+			{
+				taken.data[i] = min(need.data[i], credit_limit.data[i]);
+				if (available.data[i] < taken.data[i])
+					return false;
+				available.data[i] -= taken.data[i];
+			}
+		}
+		return true;
+	}
+
+	uint64_t Layer::Credit_Delay(Transaction t, string type)
+	{
+		if (!flow_control)
+			return 0;
+
+		CreditSet need_down, need_up;
+		Credits_Needed(t, type, need_down, need_up);
+
+		// Each time a transfer fills the receiver's buffer it has to wait for credits to come back.
+		uint64_t refills = 0;
+		CreditSet *need[2] = {&need_down, &need_up};
+		for (uint n=0; n < 2; n++)
+		{
+			for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+			{
+				if ((credit_limit.header[i] != 0) && (need[n]->header[i] > 0))
+					refills = max(refills, (need[n]->header[i] - 1) / credit_limit.header[i]);
+				if ((credit_limit.data[i] != 0) && (need[n]->data[i] > 0))
+					refills = max(refills, (need[n]->data[i] - 1) / credit_limit.data[i]);
+			}
+		}
+
+		return refills * credit_return_delay;
+	}
+
+	void Layer::Release_Credits()
+	{
+		while ((!credit_returns.empty()) && (credit_returns.front().time <= parent->currentClockCycle))
+		{
+			CreditReturn r = credit_returns.front();
+			credit_returns.pop_front();
+
+			for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+			{
+				down_credits.header[i] += r.down.header[i];
+				down_credits.data[i] += r.down.data[i];
+				up_credits.header[i] += r.up.header[i];
+				up_credits.data[i] += r.up.data[i];
+				assert(down_credits.header[i] <= credit_limit.header[i]);
+				assert(down_credits.data[i] <= credit_limit.data[i]);
+				assert(up_credits.header[i] <= credit_limit.header[i]);
+				assert(up_credits.data[i] <= credit_limit.data[i]);
+			}
+		}
+	}
+
+	uint64_t Layer::Wake_Link()
+	{
+		uint64_t now = parent->currentClockCycle;
+
+		// If the other direction is already using the link, this transfer only waits for any exit in progress.
+		if (send_busy || return_busy)
+			return (ready_time > now) ? ready_time - now : 0;
+
+		uint64_t l0s, l1;
+		Idle_Time_In_States(now - idle_since, l0s, l1);
+		l0s_cycles += l0s;
+		l1_cycles += l1;
+
+		uint64_t exit_latency = 0;
+		if (l1 > 0)
+		{
+			l1_exits++;
+			exit_latency = l1_exit;
+		}
+		else if (l0s > 0)
+		{
+			l0s_exits++;
+			exit_latency = l0s_exit;
+		}
+
+		if ((DEBUG) && (exit_latency > 0))
+		{
+			(parent->debug_file) << now << " : " << layer_name << " waking from " << ((l1 > 0) ? "L1" : "L0s") 
+					<< " (exit latency " << exit_latency << ")\n";
+			parent->debug_file.flush();
+		}
+
+		exit_cycles += exit_latency;
+		ready_time = now + exit_latency;
+		return exit_latency;
+	}
+
+	void Layer::Idle_Time_In_States(uint64_t idle, uint64_t &l0s, uint64_t &l1)
+	{
+		l0s = 0;
+		l1 = 0;
+
+		// The link stays in L0 for the first part of the idle period, then L0s, then L1.
+		uint64_t l1_start = (l1_entry != 0) ? l1_entry : idle;
+		if ((l1_entry != 0) && (idle > l1_start))
+			l1 = idle - l1_start;
+		if ((l0s_entry != 0) && (min(idle, l1_start) > l0s_entry))
+			l0s = min(idle, l1_start) - l0s_entry;
+	}
+
+	void Layer::Print_Stats(ostream &out)
+	{
+		if (merge)
+			out << "PCI_SSD " << layer_name << " merged " << merged_transactions << " transactions\n";
+
+		if (flow_control)
+			out << "PCI_SSD " << layer_name << " credit stall cycles (send: " << send_credit_stalls 
+					<< ", return: " << return_credit_stalls << ")\n";
+
+		if (ncq)
+			out << "PCI_SSD " << layer_name << " NCQ peak tags in use: " << peak_tags << " of " << ncq_depth
+					<< ", tag stall cycles: " << tag_stalls << "\n";
+
+		if (aspm)
+		{
+			// Include the idle period the link is in right now.
+			uint64_t l0s = l0s_cycles, l1 = l1_cycles;
+			if ((!send_busy) && (!return_busy))
+			{
+				uint64_t cur_l0s, cur_l1;
+				Idle_Time_In_States(parent->currentClockCycle - idle_since, cur_l0s, cur_l1);
+				l0s += cur_l0s;
+				l1 += cur_l1;
+			}
+
+			uint64_t total = max(parent->currentClockCycle, (uint64_t)1);
+			out << "PCI_SSD " << layer_name << " link power states\n";
+			out << "\tL0: " << (total - l0s - l1) << " ns (" << (double)(total - l0s - l1) / total << ")\n";
+			out << "\tL0s: " << l0s << " ns (" << (double)l0s / total << "), exits: " << l0s_exits << "\n";
+			out << "\tL1: " << l1 << " ns (" << (double)l1 / total << "), exits: " << l1_exits << "\n";
+			out << "\texit latency paid: " << exit_cycles << " ns\n";
+		}
+	}
+
+	// Only the state is checkpointed. The parameters come from the config of the system that restores it.
+	void Layer::Save(ostream &out)
+	{
+		save_value(out, send_busy);
+		save_value(out, return_busy);
+		save_value(out, send_queue);
+		save_value(out, return_queue);
+		send_scheduler->Save(out);
+		return_scheduler->Save(out);
+		save_value(out, send_remainder);
+		save_value(out, return_remainder);
+		save_value(out, down_credits);
+		save_value(out, up_credits);
+		save_value(out, send_credits);
+		save_value(out, return_credits);
+		save_value(out, credit_returns);
+		save_value(out, idle_since);
+		save_value(out, ready_time);
+		save_value(out, merged_transactions);
+		save_value(out, send_credit_stalls);
+		save_value(out, return_credit_stalls);
+		save_value(out, ncq_tags);
+		save_value(out, data_queue);
+		save_value(out, send_data_phase);
+		save_value(out, tag_stalls);
+		save_value(out, peak_tags);
+		save_value(out, l0s_cycles);
+		save_value(out, l1_cycles);
+		save_value(out, l0s_exits);
+		save_value(out, l1_exits);
+		save_value(out, exit_cycles);
+	}
+
+	void Layer::Restore(istream &in)
+	{
+		restore_value(in, send_busy);
+		restore_value(in, return_busy);
+		restore_value(in, send_queue);
+		restore_value(in, return_queue);
+		send_scheduler->Restore(in);
+		return_scheduler->Restore(in);
+		restore_value(in, send_remainder);
+		restore_value(in, return_remainder);
+		restore_value(in, down_credits);
+		restore_value(in, up_credits);
+		restore_value(in, send_credits);
+		restore_value(in, return_credits);
+		restore_value(in, credit_returns);
+		restore_value(in, idle_since);
+		restore_value(in, ready_time);
+		restore_value(in, merged_transactions);
+		restore_value(in, send_credit_stalls);
+		restore_value(in, return_credit_stalls);
+		restore_value(in, ncq_tags);
+		restore_value(in, data_queue);
+		restore_value(in, send_data_phase);
+		restore_value(in, tag_stalls);
+		restore_value(in, peak_tags);
+		restore_value(in, l0s_cycles);
+		restore_value(in, l1_cycles);
+		restore_value(in, l0s_exits);
+		restore_value(in, l1_exits);
+		restore_value(in, exit_cycles);
+	}
+}
@@ -32,41 +32,105 @@
 #define PCI_SSD_LAYER_H
 
 #include "common.h"
+#include "LinkModel.h"
+#include "Scheduler.h"
 
 namespace PCISSD
 {
 	// Forward declare.
 	class PCI_SSD_System;
 
+	enum CreditType
+	{
+		POSTED_CREDIT,
+		NON_POSTED_CREDIT,
+		COMPLETION_CREDIT,
+		NUM_CREDIT_TYPES
+	};
+
+	// PCIe flow control credits. Data credits are 16 bytes each.
+	class CreditSet
+	{
+		public:
+		uint64_t header[NUM_CREDIT_TYPES];
+		uint64_t data[NUM_CREDIT_TYPES];
+
+		CreditSet()
+		{
+			for (uint i=0; i < NUM_CREDIT_TYPES; i++)
+			{
+				header[i] = 0;
+				data[i] = 0;
+			}
+		}
+	};
+
+	// Credits to give back to the receivers at each end of a link.
+	class CreditReturn
+	{
+		public:
+		uint64_t time;
+		CreditSet down; // Receiver on the device side.
+		CreditSet up; // Receiver on the host side.
+
+		CreditReturn()
+		{
+			time = 0;
+		}
+	};
+
 	class Layer
 	{
 		public:
-		Layer(PCI_SSD_System *parent, uint64_t data_delay, uint64_t command_delay, uint64_t num_lanes, bool full_duplex,
-				TransactionEventType send_event_type, TransactionEventType return_event_type, string layer_name);
+		Layer(PCI_SSD_System *parent, uint id, LinkModel *link, bool full_duplex, bool merge, string layer_name);
+		~Layer();
 
 		void update();
 		void Add_Send_Transaction(Transaction t);
 		void Add_Return_Transaction(Transaction t);
 
-		void Send_Event_Done(Transaction t);
+		// Returns false if the transaction has another transfer to make on this link before it moves on.
+		bool Send_Event_Done(Transaction t);
 		void Return_Event_Done(Transaction t);
 
 		// Internal functions
 		void Send_Event_Start(Transaction t);
 		void Return_Event_Start(Transaction t);
 
-		void Event_Start(Transaction t, uint64_t write_delay, uint64_t read_delay, TransactionEventType event_type, string type);
+		void Event_Start(Transaction t, uint64_t delay, TransactionEventType event_type, string type);
+		uint64_t To_Cycles(uint64_t ps, uint64_t &remainder);
 		void Event_Done(Transaction t, string type);
 
+		Transaction Merge_Send_Transaction(Transaction t);
+
+		// NCQ functions
+		bool Start_Send_Transaction(); // Returns false if the command has to wait for a tag.
+		void Release_Tag(Transaction t);
+
+		// Flow control functions
+		void Credits_Needed(Transaction t, string type, CreditSet &down, CreditSet &up);
+		bool Reserve_Credits(Transaction t, string type);
+		bool Take_Credits(CreditSet &need, CreditSet &available, CreditSet &taken);
+		uint64_t Credit_Delay(Transaction t, string type);
+		void Release_Credits();
+
+		// Power management functions
+		uint64_t Wake_Link();
+		void Idle_Time_In_States(uint64_t idle, uint64_t &l0s, uint64_t &l1);
+
+		void Print_Stats(ostream &out);
+
+		// Checkpoint functions
+		void Save(ostream &out);
+		void Restore(istream &in);
+
 
 		// Parameters
 		PCI_SSD_System *parent;
-		uint64_t data_delay;
-		uint64_t command_delay;
-		uint64_t num_lanes;
+		uint id; // Index of this link in the topology. Tags the events this link creates.
+		LinkModel *link;
 		bool full_duplex;
-		TransactionEventType send_event_type;
-		TransactionEventType return_event_type;
+		bool merge;
 		string layer_name;
 
 		// Internal state
@@ -74,6 +138,48 @@ namespace PCISSD
 		bool return_busy;
 		list<Transaction> send_queue;
 		list<Transaction> return_queue;
+		Scheduler *send_scheduler; // Picks the next transaction from each queue.
+		Scheduler *return_scheduler;
+		uint64_t send_remainder; // Fraction of a cycle (in ps) carried over to the next transfer in each direction.
+		uint64_t return_remainder;
+
+		// Flow control state
+		bool flow_control;
+		uint64_t credit_return_delay;
+		CreditSet credit_limit; // Credits advertised by each receiver (0 is infinite).
+		CreditSet down_credits; // Credits available at the device side receiver.
+		CreditSet up_credits; // Credits available at the host side receiver.
+		CreditReturn send_credits; // Credits held by the transfer in flight in each direction.
+		CreditReturn return_credits;
+		list<CreditReturn> credit_returns; // Credits on their way back to the sender, in time order.
+
+		// NCQ state
+		bool ncq;
+		uint64_t ncq_depth;
+		set<pair<uint, uint64_t> > ncq_tags; // Device and address of each command holding a tag, since addresses are per device.
+		list<Transaction> data_queue; // Writes at the device waiting for their data phase.
+		bool send_data_phase; // The send in flight is the data phase of a write.
+
+		// Power management state
+		bool aspm;
+		uint64_t l0s_entry; // ASPM entry and exit times in cycles (an entry time of 0 disables the state).
+		uint64_t l0s_exit;
+		uint64_t l1_entry;
+		uint64_t l1_exit;
+		uint64_t idle_since; // Cycle the link last went idle.
+		uint64_t ready_time; // Cycle the link finishes its current exit from a low power state.
+
+		// Stats
+		uint64_t merged_transactions; // Transactions that were absorbed into another one.
+		uint64_t send_credit_stalls; // Cycles the head of each queue waited for credits.
+		uint64_t return_credit_stalls;
+		uint64_t tag_stalls; // Cycles the head of the send queue waited for an NCQ tag.
+		uint64_t peak_tags;
+		uint64_t l0s_cycles; // Cycles spent in each low power state.
+		uint64_t l1_cycles;
+		uint64_t l0s_exits;
+		uint64_t l1_exits;
+		uint64_t exit_cycles; // Cycles transfers waited for the link to come back to L0.
 	};
 }
 
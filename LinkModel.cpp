@@ -0,0 +1,283 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "LinkModel.h"
+
+namespace PCISSD
+{
+	LinkModel::LinkModel(uint64_t type, uint64_t lanes, const Config &config)
+	{
+		assert(lanes > 0);
+		assert(config.pcie_max_payload > 0);
+		assert(config.pcie_max_read_request > 0);
+		assert(config.pcie_read_completion_boundary > 0);
+
+		this->type = type;
+		this->lanes = lanes;
+		this->max_payload = config.pcie_max_payload;
+		this->max_read_request = config.pcie_max_read_request;
+		this->completion_size = config.pcie_completion_coalescing ? config.pcie_max_payload
+				: min(config.pcie_read_completion_boundary, config.pcie_max_payload);
+		this->ack_factor = config.pcie_ack_factor;
+		this->fc_update_factor = config.pcie_fc_update_factor;
+		this->fis_overhead = config.sata_fis_overhead;
+
+		pcie = false;
+		flit = false;
+		sata = false;
+		bytes_per_second = 0;
+		ps_per_byte = 0;
+
+		// Framing (STP/END or the 128b/130b STP token), sequence number and LCRC around every TLP header.
+		// DLLPs are 6 bytes plus 2 bytes of framing.
+		tlp_overhead = config.pcie_tlp_header + 8;
+		dllp_size = 8;
+
+		switch (type)
+		{
+			case NONE:
+				break;
+			case SATA2:
+				sata = true;
+				bytes_per_second = 300000000; // 300 MB/s (375 MB/s without PHY overhead)
+				break;
+			case SATA3:
+				sata = true;
+				bytes_per_second = 600000000; // 600 MB/s (750 MB/s without PHY overhead)
+				break;
+			case DMI2:
+				bytes_per_second = 2500000000; // 2.5 GB/s
+				break;
+			case PCI1:
+				pcie = true;
+				ps_per_byte = 1000.0 * 10.0 / 2.5; // 2.5 GT/s, 8b/10b
+				break;
+			case PCI2:
+				pcie = true;
+				ps_per_byte = 1000.0 * 10.0 / 5.0; // 5 GT/s, 8b/10b
+				break;
+			case PCI3:
+				pcie = true;
+				ps_per_byte = 1000.0 * 8.0 * 130.0 / 128.0 / 8.0; // 8 GT/s, 128b/130b
+				break;
+			case PCI4:
+				pcie = true;
+				ps_per_byte = 1000.0 * 8.0 * 130.0 / 128.0 / 16.0; // 16 GT/s, 128b/130b
+				break;
+			case PCI5:
+				pcie = true;
+				ps_per_byte = 1000.0 * 8.0 * 130.0 / 128.0 / 32.0; // 32 GT/s, 128b/130b
+				break;
+			case PCI6:
+				// 64 GT/s PAM4 with no line encoding. TLPs are packed into 256 byte FLITs with their own
+				// CRC and FEC, so TLPs carry no framing or LCRC and DLLPs ride in the FLIT's DLP bytes.
+				pcie = true;
+				flit = true;
+				ps_per_byte = 1000.0 * 8.0 / 64.0;
+				tlp_overhead = config.pcie_tlp_header;
+				break;
+			default:
+				cerr << "ERROR: Unknown interface type " << type << ".\n";
+				abort();
+		}
+
+		// Every Layer transfer is a whole number of sectors, so the times are looked up instead of
+		// recomputed for every transfer. The link settings are only known at run time (TOPOLOGY), so
+		// the tables are built here rather than at compile time.
+		if (pcie)
+			command_time = To_Picoseconds(Posted_Bytes(COMMAND_SIZE));
+		else
+			command_time = compute_interface_time(COMMAND_SIZE, bytes_per_second, PROTOCOL_EFFICIENCY) / lanes;
+
+		posted_time.resize(MAX_SECTORS + 1);
+		completion_time.resize(MAX_SECTORS + 1);
+		for (uint64_t n=0; n <= MAX_SECTORS; n++)
+		{
+			posted_time[n] = Compute_Data_Time(n * SECTOR_SIZE, false);
+			completion_time[n] = Compute_Data_Time(n * SECTOR_SIZE, true);
+		}
+	}
+
+	uint64_t LinkModel::Command_Time()
+	{
+		return command_time;
+	}
+
+	uint64_t LinkModel::Data_Time(uint64_t num_bytes, bool completion)
+	{
+		uint64_t n = num_bytes / SECTOR_SIZE;
+		if ((num_bytes % SECTOR_SIZE == 0) && (n <= MAX_SECTORS))
+			return completion ? completion_time[n] : posted_time[n];
+
+		return Compute_Data_Time(num_bytes, completion);
+	}
+
+	uint64_t LinkModel::FIS_Command_Time()
+	{
+		return FIS_Time(SATA_REG_H2D_FIS);
+	}
+
+	uint64_t LinkModel::FIS_Data_Time(uint64_t num_bytes)
+	{
+		// Each Data FIS carries at most SATA_MAX_DATA_FIS bytes.
+		uint64_t full_fises = num_bytes / SATA_MAX_DATA_FIS;
+		uint64_t rest = num_bytes % SATA_MAX_DATA_FIS;
+
+		uint64_t ps = FIS_Time(SATA_DMA_SETUP_FIS) + full_fises * FIS_Time(SATA_DATA_FIS_HEADER + SATA_MAX_DATA_FIS);
+		if (rest > 0)
+			ps += FIS_Time(SATA_DATA_FIS_HEADER + rest);
+		return ps;
+	}
+
+	uint64_t LinkModel::FIS_Status_Time()
+	{
+		return FIS_Time(SATA_SET_DEVICE_BITS_FIS);
+	}
+
+	uint64_t LinkModel::FIS_Time(uint64_t fis_bytes)
+	{
+		return compute_interface_time(fis_bytes + fis_overhead, bytes_per_second, PROTOCOL_EFFICIENCY) / lanes;
+	}
+
+	uint64_t LinkModel::Compute_Data_Time(uint64_t num_bytes, bool completion)
+	{
+		if (!pcie)
+			return compute_interface_time(COMMAND_SIZE + num_bytes, bytes_per_second, PROTOCOL_EFFICIENCY) / lanes;
+
+		double wire_bytes = Posted_Bytes(COMMAND_SIZE);
+		wire_bytes += completion ? Completion_Bytes(num_bytes) : Posted_Bytes(num_bytes);
+		return To_Picoseconds(wire_bytes);
+	}
+
+	double LinkModel::TLP_Bytes(uint64_t payload, uint64_t num_tlps)
+	{
+		double wire_bytes = payload + num_tlps * tlp_overhead;
+
+		if (flit)
+		{
+			// 236 of every 256 FLIT bytes carry TLPs. The rest is DLP, CRC and FEC.
+			return wire_bytes * 256.0 / 236.0;
+		}
+
+		// ACK and UpdateFC DLLPs for these TLPs. They travel in the other direction, but the traffic
+		// in the other direction pays the same for its own TLPs, so they are charged here.
+		uint64_t acks = (num_tlps + ack_factor - 1) / ack_factor;
+		uint64_t fc_updates = (num_tlps + fc_update_factor - 1) / fc_update_factor;
+		return wire_bytes + (acks + fc_updates) * dllp_size;
+	}
+
+	uint64_t LinkModel::Posted_TLPs(uint64_t payload)
+	{
+		// Memory writes are split at the max payload size.
+		return (payload + max_payload - 1) / max_payload;
+	}
+
+	uint64_t LinkModel::Read_Requests(uint64_t payload)
+	{
+		// Reads are split into requests of at most max_read_request bytes.
+		return (payload + max_read_request - 1) / max_read_request;
+	}
+
+	uint64_t LinkModel::Completion_TLPs(uint64_t payload)
+	{
+		// Each read request is answered by its own completions, which never hold more than completion_size bytes.
+		uint64_t full_requests = payload / max_read_request;
+		uint64_t last_request = payload % max_read_request;
+
+		uint64_t num_completions = full_requests * ((max_read_request + completion_size - 1) / completion_size);
+		num_completions += (last_request + completion_size - 1) / completion_size;
+		return num_completions;
+	}
+
+	double LinkModel::Posted_Bytes(uint64_t payload)
+	{
+		return TLP_Bytes(payload, Posted_TLPs(payload));
+	}
+
+	double LinkModel::Completion_Bytes(uint64_t payload)
+	{
+		// The requests travel the other way, but each one has to arrive before its completions can start.
+		return TLP_Bytes(payload, Completion_TLPs(payload)) + Read_Requests(payload) * tlp_overhead;
+	}
+
+	uint64_t LinkModel::To_Picoseconds(double wire_bytes)
+	{
+		// The lanes carry the bytes in parallel.
+		return (uint64_t)llround(wire_bytes * ps_per_byte / lanes);
+	}
+
+
+	// Helper function to compute the time in picoseconds to move num_bytes over a layer interface.
+	uint64_t compute_interface_time(uint64_t num_bytes, uint64_t bytes_per_second, uint64_t efficiency)
+	{
+		if (bytes_per_second == 0)
+		{
+			// For the NONE case.
+			return 0;
+		}
+		else
+		{
+			double efficiency_percentage = double(efficiency) / 100.0;
+			double total_bytes = (double)(num_bytes) / efficiency_percentage;
+			double in_seconds = total_bytes / (double)(bytes_per_second);
+			double in_picoseconds = in_seconds * 1000000000000.0;
+			return (uint64_t)llround(in_picoseconds);
+		}
+	}
+
+	// Helper function to look up an interface type by name (for TOPOLOGY and config files).
+	uint64_t interface_type(string name)
+	{
+		if (name == "SATA2")
+			return SATA2;
+		else if (name == "SATA3")
+			return SATA3;
+		else if (name == "DMI2")
+			return DMI2;
+		else if (name == "PCI1")
+			return PCI1;
+		else if (name == "PCI2")
+			return PCI2;
+		else if (name == "PCI3")
+			return PCI3;
+		else if (name == "PCI4")
+			return PCI4;
+		else if (name == "PCI5")
+			return PCI5;
+		else if (name == "PCI6")
+			return PCI6;
+		else if (name == "NONE")
+			return NONE;
+
+		cerr << "ERROR: Unknown interface type " << name << ".\n";
+		abort();
+	}
+}
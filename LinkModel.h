@@ -0,0 +1,107 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_LINKMODEL_H
+#define PCI_SSD_LINKMODEL_H
+
+#include "common.h"
+#include "config.h"
+#include "Config.h"
+
+namespace PCISSD
+{
+	// Timing model for one direction of a link.
+	// PCIe links (PCI1 to PCI6) account for line encoding, TLP framing/header/LCRC, ACK and UpdateFC
+	// DLLPs, max payload and max read request splitting, and FLIT framing for PCIe 6.0.
+	// The other interfaces apply PROTOCOL_EFFICIENCY to their data rate.
+	// Times are in picoseconds so that the Layer can carry the fraction of a cycle from one transfer to the next.
+	class LinkModel
+	{
+		public:
+		LinkModel(uint64_t type, uint64_t lanes, const Config &config);
+
+		// Time in ps to send a command (or a completion without data) across the link.
+		uint64_t Command_Time();
+
+		// Time in ps to send a command followed by num_bytes of data.
+		// If completion is set, the data is returned for read requests issued by the receiver
+		// (DMA reads of host memory). Otherwise it is sent as posted writes.
+		uint64_t Data_Time(uint64_t num_bytes, bool completion);
+
+		// Times in ps for the FISes of a SATA NCQ command (see NCQ_DEPTH in config.h): the Register H2D FIS
+		// that issues it, a DMA Setup FIS with the Data FISes that move num_bytes, and the Set Device Bits
+		// FIS that completes it.
+		uint64_t FIS_Command_Time();
+		uint64_t FIS_Data_Time(uint64_t num_bytes);
+		uint64_t FIS_Status_Time();
+
+		// Number of TLPs needed to move payload bytes.
+		uint64_t Posted_TLPs(uint64_t payload);
+		uint64_t Read_Requests(uint64_t payload);
+		uint64_t Completion_TLPs(uint64_t payload);
+
+		// Internal functions
+		uint64_t Compute_Data_Time(uint64_t num_bytes, bool completion);
+		double TLP_Bytes(uint64_t payload, uint64_t num_tlps);
+		double Posted_Bytes(uint64_t payload);
+		double Completion_Bytes(uint64_t payload);
+		uint64_t To_Picoseconds(double wire_bytes);
+		uint64_t FIS_Time(uint64_t fis_bytes);
+
+
+		// Parameters
+		uint64_t type;
+		uint64_t lanes;
+		bool pcie;
+		bool flit;
+		bool sata;
+		uint64_t bytes_per_second; // Data rate of the non-PCIe interfaces.
+		double ps_per_byte; // Time to move one byte over one PCIe lane, including line encoding.
+		uint64_t tlp_overhead; // Bytes added to every TLP.
+		uint64_t dllp_size;
+		uint64_t max_payload;
+		uint64_t max_read_request;
+		uint64_t completion_size; // Largest completion returned for a read request.
+		uint64_t ack_factor;
+		uint64_t fc_update_factor;
+		uint64_t fis_overhead; // Bytes of framing and handshake primitives around every SATA FIS.
+
+		// Transfer times for every whole number of sectors, filled in by the constructor.
+		uint64_t command_time;
+		vector<uint64_t> posted_time;
+		vector<uint64_t> completion_time;
+	};
+
+	uint64_t compute_interface_time(uint64_t num_bytes, uint64_t bytes_per_second, uint64_t efficiency);
+	uint64_t interface_type(string name);
+}
+
+#endif
@@ -33,29 +33,58 @@
 #define PCI_SSD_H
 
 #include <stdint.h>
+#include <string>
+#include <iostream>
 #include "CallbackPCI.h"
 
 namespace PCISSD
 {
+	// Thread safety: every PCI_SSD_System is self-contained. It owns its config, debug file (named from its id),
+	// links, devices, backends and stats, and the library keeps no global state. Different instances can be
+	// driven from different threads at the same time, provided they have different ids and use the flash
+	// backend (HybridSim is not thread safe). A single instance is not thread safe, so all calls to it must
+	// come from one thread at a time. Callbacks run on the thread that calls update().
 	class PCI_SSD_System
 	{
 		public:
-		PCI_SSD_System(uint id);
+		PCI_SSD_System(uint id, std::string ini_file = "");
 		~PCI_SSD_System();
-		bool addTransaction(bool isWrite, uint64_t addr, int num_sectors);
+		// qos_class runs from 0 (most important) to NUM_QOS_CLASSES-1. Links use it to schedule (see LAYER_SCHEDULER in config.h).
+		bool addTransaction(bool isWrite, uint64_t addr, int num_sectors, uint qos_class = 0);
+
+		// Apply a transaction to the functional state (cache and prefetcher contents, flash mapping) without
+		// simulating its timing. It completes at once and makes no callback. Used to fast-forward in sampled simulation.
+		void addFunctionalTransaction(bool isWrite, uint64_t addr, int num_sectors);
+
 		bool WillAcceptTransaction();
 		void update();
 		void RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone);
 		void printLogfile();
+		void printLogfile(std::ostream &out);
 
 		// DMA functions
 		void RegisterDMACallback(DMATransactionCB *add_dma, uint64_t mem_size);
 		bool isDMATransaction(bool isWrite, uint64_t addr, bool done);
 		void CompleteDMATransaction(bool isWrite, uint64_t addr);
 		void AddDMAScatterGatherEntry(uint64_t addr, uint64_t length);
+
+		// Statistics functions
+		// Steady state is detected from windowed throughput and latency (see STATS_WINDOW in config.h).
+		// isConverged() turns true once the steady state confidence intervals are within STATS_CONFIDENCE percent.
+		bool isSteadyState();
+		bool isConverged();
+
+		// Checkpoint functions
+		// SaveCheckpoint() writes the complete simulator state to a binary file. RestoreCheckpoint() loads it into an
+		// instance built with the same configuration, which then continues exactly as the saved one would have.
+		// Callbacks are not saved, so they stay as registered on the restoring instance. DMA accesses outstanding
+		// in the host memory model must be restored by the host. Not supported with the HybridSim backend.
+		void SaveCheckpoint(std::string filename);
+		void RestoreCheckpoint(std::string filename);
 	};
 
 	PCI_SSD_System *getInstance(uint id);
+	PCI_SSD_System *getInstance(uint id, std::string ini_file); // Override the config.h defaults with an ini file.
 }
 
 #endif
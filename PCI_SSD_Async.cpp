@@ -0,0 +1,279 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "PCI_SSD_Async.h"
+
+namespace PCISSD
+{
+	PCI_SSD_Async::PCI_SSD_Async(uint id, Config config, uint64_t horizon, uint64_t ring_size) :
+		submission_ring(ring_size), completion_ring(ring_size), dma_ring(ring_size), host_cycle(0), sim_done(0), stop(false)
+	{
+		system = new PCI_SSD_System(id, config);
+
+		// The system only ever calls these on the simulation thread.
+		typedef Callback<PCI_SSD_Async, void, uint, uint64_t, uint64_t> async_callback_t;
+		read_cb = new async_callback_t(this, &PCI_SSD_Async::read_complete);
+		write_cb = new async_callback_t(this, &PCI_SSD_Async::write_complete);
+		dma_cb = new async_callback_t(this, &PCI_SSD_Async::add_dma_request);
+		system->RegisterCallbacks(read_cb, write_cb);
+
+		this->horizon = horizon;
+
+		ReadDone = NULL;
+		WriteDone = NULL;
+		add_dma = NULL;
+		currentClockCycle = 0;
+		sim_cycle = 0;
+
+		sim_thread = thread(&PCI_SSD_Async::Run, this);
+	}
+
+	PCI_SSD_Async::~PCI_SSD_Async()
+	{
+		Sync();
+
+		stop.store(true);
+		sim_thread.join();
+
+		delete system;
+		delete read_cb;
+		delete write_cb;
+		delete dma_cb;
+	}
+
+	bool PCI_SSD_Async::addTransaction(bool isWrite, uint64_t addr, int num_sectors, uint qos_class)
+	{
+		AsyncRequest r = {ASYNC_TRANSACTION, currentClockCycle, isWrite, addr, (uint64_t)num_sectors, qos_class};
+		Submit(r);
+
+		return true;
+	}
+
+	bool PCI_SSD_Async::WillAcceptTransaction()
+	{
+		return true;
+	}
+
+	void PCI_SSD_Async::update()
+	{
+		// Let the simulation thread run this cycle.
+		uint64_t cycle = currentClockCycle;
+		currentClockCycle++;
+		host_cycle.store(currentClockCycle, memory_order_release);
+
+		if (cycle < horizon)
+			return;
+
+		// Deliver what the system did horizon cycles ago, waiting for it if the simulation thread is behind.
+		uint64_t up_to = cycle - horizon;
+		while (sim_done.load(memory_order_acquire) <= up_to)
+		{
+			Drain_Events();
+			this_thread::yield();
+		}
+
+		Drain_Events();
+		Deliver_Events(up_to);
+	}
+
+	void PCI_SSD_Async::RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone)
+	{
+		ReadDone = readDone;
+		WriteDone = writeDone;
+	}
+
+	void PCI_SSD_Async::printLogfile(ostream &out)
+	{
+		// The simulation thread leaves the system alone until the host moves on.
+		Sync();
+		system->printLogfile(out);
+	}
+
+	void PCI_SSD_Async::RegisterDMACallback(DMATransactionCB *add_dma, uint64_t mem_size)
+	{
+		this->add_dma = add_dma;
+
+		AsyncRequest r = {ASYNC_REGISTER_DMA, currentClockCycle, false, 0, mem_size};
+		Submit(r);
+	}
+
+	bool PCI_SSD_Async::isDMATransaction(bool isWrite, uint64_t addr, bool done)
+	{
+		// Answer from the DMA accesses the memory model has been given, since the system itself is on the other thread.
+		if ((done) || (dma_pending.count(addr) == 0))
+			return false;
+
+		return dma_pending[addr] == isWrite;
+	}
+
+	void PCI_SSD_Async::CompleteDMATransaction(bool isWrite, uint64_t addr)
+	{
+		assert(dma_pending.count(addr) == 1);
+		dma_pending.erase(addr);
+
+		AsyncRequest r = {ASYNC_DMA_COMPLETE, currentClockCycle, isWrite, addr, 0};
+		Submit(r);
+	}
+
+	void PCI_SSD_Async::AddDMAScatterGatherEntry(uint64_t addr, uint64_t length)
+	{
+		AsyncRequest r = {ASYNC_SG_ENTRY, currentClockCycle, false, addr, length};
+		Submit(r);
+	}
+
+	void PCI_SSD_Async::Sync()
+	{
+		while (sim_done.load(memory_order_acquire) != currentClockCycle)
+		{
+			Drain_Events();
+			this_thread::yield();
+		}
+
+		Drain_Events();
+		if (currentClockCycle > 0)
+			Deliver_Events(currentClockCycle - 1);
+	}
+
+	void PCI_SSD_Async::Submit(AsyncRequest r)
+	{
+		// Keep draining while the ring is full, in case the simulation thread is waiting on a full event ring.
+		while (!submission_ring.Push(r))
+		{
+			Drain_Events();
+			this_thread::yield();
+		}
+	}
+
+	void PCI_SSD_Async::Drain_Events()
+	{
+		AsyncEvent e;
+		while (dma_ring.Pop(e))
+			dma_requests.push_back(e);
+		while (completion_ring.Pop(e))
+			completions.push_back(e);
+	}
+
+	void PCI_SSD_Async::Deliver_Events(uint64_t up_to)
+	{
+		// DMA requests go first. They are independent of the completions made on the same cycle.
+		while ((!dma_requests.empty()) && (dma_requests.front().cycle <= up_to))
+		{
+			AsyncEvent e = dma_requests.front();
+			dma_requests.pop_front();
+
+			assert(add_dma != NULL);
+			assert(dma_pending.count(e.addr) == 0);
+			dma_pending[e.addr] = e.isWrite;
+			(*add_dma)(e.isWrite, e.addr, 0);
+		}
+
+		while ((!completions.empty()) && (completions.front().cycle <= up_to))
+		{
+			AsyncEvent e = completions.front();
+			completions.pop_front();
+
+			TransactionCompleteCB *cb = e.isWrite ? WriteDone : ReadDone;
+			if (cb != NULL)
+				(*cb)(system->systemID, e.addr, e.clock_cycle);
+		}
+	}
+
+
+	void PCI_SSD_Async::Run()
+	{
+		while (true)
+		{
+			// Read the host's cycle before draining, so every request made before it is already on the ring.
+			uint64_t limit = host_cycle.load(memory_order_acquire);
+
+			AsyncRequest r;
+			while (submission_ring.Pop(r))
+				requests.push_back(r);
+
+			if (sim_cycle == limit)
+			{
+				if (stop.load())
+					return;
+				this_thread::yield();
+				continue;
+			}
+
+			while (sim_cycle < limit)
+			{
+				// Replay the host's calls for this cycle in the order it made them, then update as the host would have.
+				while ((!requests.empty()) && (requests.front().cycle == sim_cycle))
+				{
+					r = requests.front();
+					requests.pop_front();
+
+					if (r.type == ASYNC_TRANSACTION)
+						system->addTransaction(r.isWrite, r.addr, r.size, r.qos_class);
+					else if (r.type == ASYNC_SG_ENTRY)
+						system->AddDMAScatterGatherEntry(r.addr, r.size);
+					else if (r.type == ASYNC_DMA_COMPLETE)
+						system->CompleteDMATransaction(r.isWrite, r.addr);
+					else if (r.type == ASYNC_REGISTER_DMA)
+						system->RegisterDMACallback(dma_cb, r.size);
+				}
+				assert((requests.empty()) || (requests.front().cycle > sim_cycle));
+
+				system->update();
+				sim_cycle++;
+				sim_done.store(sim_cycle, memory_order_release);
+			}
+		}
+	}
+
+	void PCI_SSD_Async::read_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		AsyncEvent e = {sim_cycle, false, addr, clock_cycle};
+		Push_Event(completion_ring, e);
+	}
+
+	void PCI_SSD_Async::write_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		AsyncEvent e = {sim_cycle, true, addr, clock_cycle};
+		Push_Event(completion_ring, e);
+	}
+
+	void PCI_SSD_Async::add_dma_request(uint isWrite, uint64_t addr, uint64_t unused)
+	{
+		AsyncEvent e = {sim_cycle, isWrite != 0, addr, 0};
+		Push_Event(dma_ring, e);
+	}
+
+	void PCI_SSD_Async::Push_Event(SPSCRing<AsyncEvent> &ring, AsyncEvent e)
+	{
+		// The host drains the rings on every update, so this only waits while the host is busy elsewhere.
+		while (!ring.Push(e))
+			this_thread::yield();
+	}
+}
@@ -0,0 +1,143 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_ASYNC_H
+#define PCI_SSD_ASYNC_H
+
+#include "PCI_SSD_System.h"
+#include "SPSCRing.h"
+#include <thread>
+
+namespace PCISSD
+{
+	enum AsyncRequestType
+	{
+		ASYNC_TRANSACTION,
+		ASYNC_SG_ENTRY,
+		ASYNC_DMA_COMPLETE,
+		ASYNC_REGISTER_DMA
+	};
+
+	// Host call for the simulation thread to replay, tagged with the host cycle it was made on.
+	class AsyncRequest
+	{
+		public:
+		AsyncRequestType type;
+		uint64_t cycle;
+		bool isWrite;
+		uint64_t addr;
+		uint64_t size; // Sectors for a transaction, bytes for a scatter gather entry, memory size for a DMA registration.
+		uint qos_class;
+	};
+
+	// Completion or DMA request for the host, tagged with the cycle the system made it on.
+	class AsyncEvent
+	{
+		public:
+		uint64_t cycle;
+		bool isWrite;
+		uint64_t addr;
+		uint64_t clock_cycle; // Internal cycle passed to the completion callback.
+	};
+
+	// Runs a PCI_SSD_System on its own thread so the host only pays for queueing its calls.
+	// addTransaction(), AddDMAScatterGatherEntry() and CompleteDMATransaction() are tagged with the host cycle
+	// and passed to the simulation thread through a submission ring. The simulation thread replays each one on
+	// the cycle it was made on, so the system sees exactly what it would see if the host called it directly.
+	// Completions and DMA requests come back through their own rings.
+	// The simulation thread never passes the host, and the host never gets more than horizon cycles ahead of
+	// it. Everything the system does on cycle c is delivered to the host on cycle c + horizon, so callbacks
+	// arrive a fixed horizon late, with the exact completion cycle in their clock_cycle argument.
+	// Without host DMA, timing is identical to calling the system directly. With host DMA, each DMA request
+	// reaches the memory model horizon cycles late, and the DMA takes that much longer.
+	class PCI_SSD_Async
+	{
+		public:
+		PCI_SSD_Async(uint id, Config config, uint64_t horizon = 1024, uint64_t ring_size = 4096);
+		~PCI_SSD_Async();
+		bool addTransaction(bool isWrite, uint64_t addr, int num_sectors, uint qos_class = 0);
+		bool WillAcceptTransaction();
+		void update();
+		void RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone);
+		void printLogfile(ostream &out);
+
+		// DMA functions
+		void RegisterDMACallback(DMATransactionCB *add_dma, uint64_t mem_size);
+		bool isDMATransaction(bool isWrite, uint64_t addr, bool done);
+		void CompleteDMATransaction(bool isWrite, uint64_t addr);
+		void AddDMAScatterGatherEntry(uint64_t addr, uint64_t length);
+
+		// Wait for the simulation thread to catch up and deliver everything it has done so far.
+		void Sync();
+
+		// Internal functions
+		void Submit(AsyncRequest r);
+		void Drain_Events();
+		void Deliver_Events(uint64_t up_to);
+
+		// Simulation thread functions
+		void Run();
+		void read_complete(uint id, uint64_t addr, uint64_t clock_cycle);
+		void write_complete(uint id, uint64_t addr, uint64_t clock_cycle);
+		void add_dma_request(uint isWrite, uint64_t addr, uint64_t unused);
+		void Push_Event(SPSCRing<AsyncEvent> &ring, AsyncEvent e);
+
+
+		PCI_SSD_System *system;
+		TransactionCompleteCB *read_cb; // Callbacks registered with the system, freed with it.
+		TransactionCompleteCB *write_cb;
+		DMATransactionCB *dma_cb;
+		thread sim_thread;
+		uint64_t horizon;
+
+		// Host side state
+		TransactionCompleteCB *ReadDone;
+		TransactionCompleteCB *WriteDone;
+		DMATransactionCB *add_dma;
+		uint64_t currentClockCycle; // Host cycles so far.
+		list<AsyncEvent> completions; // Events taken off the rings and waiting for their delivery cycle.
+		list<AsyncEvent> dma_requests;
+		unordered_map<uint64_t, bool> dma_pending; // DMA accesses given to the memory model, and whether each one is a write.
+
+		// Simulation thread state
+		list<AsyncRequest> requests; // Requests taken off the submission ring and waiting for their cycle.
+		uint64_t sim_cycle; // Updates done by the simulation thread.
+
+		SPSCRing<AsyncRequest> submission_ring;
+		SPSCRing<AsyncEvent> completion_ring;
+		SPSCRing<AsyncEvent> dma_ring;
+		atomic<uint64_t> host_cycle; // Published by the host once every request for the cycles before it is submitted.
+		atomic<uint64_t> sim_done; // Published by the simulation thread after each update.
+		atomic<bool> stop;
+	};
+}
+
+#endif
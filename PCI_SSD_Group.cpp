@@ -0,0 +1,237 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "PCI_SSD_Group.h"
+#include <algorithm>
+
+namespace PCISSD
+{
+	GroupWorker::GroupWorker(uint id, Config config) : started(0), finished(0), stop(false)
+	{
+		system = new PCI_SSD_System(id, config);
+
+		typedef Callback<GroupWorker, void, uint, uint64_t, uint64_t> worker_callback_t;
+		read_cb = new worker_callback_t(this, &GroupWorker::read_complete);
+		write_cb = new worker_callback_t(this, &GroupWorker::write_complete);
+		system->RegisterCallbacks(read_cb, write_cb);
+
+		cycle = 0;
+		window_end = 0;
+
+		worker = thread(&GroupWorker::Run, this);
+	}
+
+	GroupWorker::~GroupWorker()
+	{
+		stop.store(true);
+		started++;
+		worker.join();
+
+		delete system;
+		delete read_cb;
+		delete write_cb;
+	}
+
+	void GroupWorker::Run()
+	{
+		uint64_t windows = 0;
+		while (true)
+		{
+			// Wait for the host to hand over the next window.
+			while (started.load(memory_order_acquire) == windows)
+				this_thread::yield();
+			if (stop.load())
+				return;
+
+			// Add each request on the cycle the host added it, then update, as the host would have.
+			vector<GroupRequest>::iterator next = window.begin();
+			while (cycle < window_end)
+			{
+				while ((next != window.end()) && (next->cycle == cycle))
+				{
+					system->addTransaction(next->isWrite, next->addr, next->num_sectors, next->qos_class);
+					next++;
+				}
+
+				system->update();
+				cycle++;
+			}
+			assert(next == window.end());
+
+			windows++;
+			finished.store(windows, memory_order_release);
+		}
+	}
+
+	void GroupWorker::read_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		GroupCompletion c = {cycle, false, id, addr, clock_cycle};
+		completions.push_back(c);
+	}
+
+	void GroupWorker::write_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		GroupCompletion c = {cycle, true, id, addr, clock_cycle};
+		completions.push_back(c);
+	}
+
+
+	PCI_SSD_Group::PCI_SSD_Group(uint num_systems, uint first_id, Config config, uint64_t quantum, bool open_loop)
+	{
+		assert(num_systems > 0);
+
+		// Space the ids out so that no two systems share backend ids or debug files.
+		for (uint s=0; s < num_systems; s++)
+			workers.push_back(new GroupWorker(first_id + s * config.num_devices, config));
+
+		// Time for a command to cross the root link, in host cycles.
+		uint64_t internal_cycles = workers[0]->system->layers[0]->link->Command_Time() / 1000;
+		uint64_t lookahead = max(internal_cycles * config.external_clock / config.internal_clock, (uint64_t)1);
+
+		// Only an open-loop host can take windows longer than the lookahead.
+		if (quantum == 0)
+			quantum = lookahead;
+		assert((open_loop) || (quantum <= lookahead));
+		this->quantum = quantum;
+		this->open_loop = open_loop;
+
+		ReadDone = NULL;
+		WriteDone = NULL;
+
+		currentClockCycle = 0;
+		window_start = 0;
+		window_running = false;
+	}
+
+	PCI_SSD_Group::~PCI_SSD_Group()
+	{
+		Finish_Window();
+
+		for (uint s=0; s < workers.size(); s++)
+			delete workers[s];
+	}
+
+	bool PCI_SSD_Group::addTransaction(uint system, bool isWrite, uint64_t addr, int num_sectors, uint qos_class)
+	{
+		assert(system < workers.size());
+
+		GroupRequest r = {currentClockCycle, isWrite, addr, num_sectors, qos_class};
+		workers[system]->pending.push_back(r);
+
+		return true;
+	}
+
+	void PCI_SSD_Group::update()
+	{
+		currentClockCycle++;
+
+		if (currentClockCycle - window_start == quantum)
+		{
+			// A closed-loop host gets this window's completions before it moves on.
+			Finish_Window();
+			Start_Window();
+			if (!open_loop)
+				Finish_Window();
+		}
+	}
+
+	void PCI_SSD_Group::RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone)
+	{
+		ReadDone = readDone;
+		WriteDone = writeDone;
+	}
+
+	void PCI_SSD_Group::printLogfile(ostream &out)
+	{
+		Sync();
+
+		for (uint s=0; s < workers.size(); s++)
+		{
+			out << "PCI_SSD system " << workers[s]->system->systemID << ":\n";
+			workers[s]->system->printLogfile(out);
+		}
+	}
+
+	void PCI_SSD_Group::Sync()
+	{
+		Finish_Window();
+		if (currentClockCycle > window_start)
+		{
+			Start_Window();
+			Finish_Window();
+		}
+	}
+
+	void PCI_SSD_Group::Start_Window()
+	{
+		assert(!window_running);
+
+		for (uint s=0; s < workers.size(); s++)
+		{
+			GroupWorker *w = workers[s];
+			w->window.swap(w->pending);
+			w->pending.clear();
+			w->window_end = currentClockCycle;
+			w->started.fetch_add(1, memory_order_release);
+		}
+
+		window_start = currentClockCycle;
+		window_running = true;
+	}
+
+	void PCI_SSD_Group::Finish_Window()
+	{
+		if (!window_running)
+			return;
+
+		// Wait for every worker, then gather their completions in a fixed order.
+		vector<GroupCompletion> done;
+		for (uint s=0; s < workers.size(); s++)
+		{
+			GroupWorker *w = workers[s];
+			while (w->finished.load(memory_order_acquire) != w->started.load())
+				this_thread::yield();
+
+			done.insert(done.end(), w->completions.begin(), w->completions.end());
+			w->completions.clear();
+		}
+		window_running = false;
+
+		stable_sort(done.begin(), done.end(), [](const GroupCompletion &a, const GroupCompletion &b) { return a.cycle < b.cycle; });
+
+		for (uint64_t i=0; i < done.size(); i++)
+		{
+			TransactionCompleteCB *cb = done[i].isWrite ? WriteDone : ReadDone;
+			if (cb != NULL)
+				(*cb)(done[i].id, done[i].addr, done[i].clock_cycle);
+		}
+	}
+}
@@ -0,0 +1,136 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_GROUP_H
+#define PCI_SSD_GROUP_H
+
+#include "PCI_SSD_System.h"
+#include <atomic>
+#include <thread>
+
+namespace PCISSD
+{
+	class GroupRequest
+	{
+		public:
+		uint64_t cycle; // Host cycle the request was added on.
+		bool isWrite;
+		uint64_t addr;
+		int num_sectors;
+		uint qos_class;
+	};
+
+	class GroupCompletion
+	{
+		public:
+		uint64_t cycle; // Host cycle the request completed on.
+		bool isWrite;
+		uint id;
+		uint64_t addr;
+		uint64_t clock_cycle; // Internal cycle passed to the callback by the system.
+	};
+
+	// One system in a PCI_SSD_Group and the thread that runs it.
+	class GroupWorker
+	{
+		public:
+		GroupWorker(uint id, Config config);
+		~GroupWorker();
+
+		void Run();
+		void read_complete(uint id, uint64_t addr, uint64_t clock_cycle);
+		void write_complete(uint id, uint64_t addr, uint64_t clock_cycle);
+
+		PCI_SSD_System *system;
+		TransactionCompleteCB *read_cb;
+		TransactionCompleteCB *write_cb;
+		thread worker;
+
+		// The host fills pending during a window. At the window boundary it becomes window, which only the
+		// worker touches until it reports the window done. completions is only touched by the worker while
+		// a window runs and by the host after it is done, so none of these need locks.
+		vector<GroupRequest> pending;
+		vector<GroupRequest> window;
+		vector<GroupCompletion> completions;
+
+		uint64_t cycle; // Next cycle the worker will simulate.
+		uint64_t window_end; // Cycle the current window stops at. Set by the host before it starts the window.
+
+		atomic<uint64_t> started; // Windows started by the host.
+		atomic<uint64_t> finished; // Windows finished by the worker.
+		atomic<bool> stop;
+	};
+
+	// Runs several PCI_SSD_Systems in parallel, each on its own worker thread.
+	// The host uses the group like a single system with an extra index argument. Time is cut into windows of
+	// quantum host cycles. Requests added during a window are handed to the workers at the end of it. Each
+	// worker adds every request on exactly the cycle the host added it, so every system sees the same inputs
+	// and produces the same timing as it would on the host thread.
+	// Completions are collected by the workers and delivered in cycle order (ties go to the lower system index),
+	// with the exact completion cycle in the clock_cycle argument, always on the same host cycle from run to run.
+	// By default the host waits for the workers at the end of each window, so every callback arrives at most
+	// one quantum late. The default quantum is the time to send a command over the root link, since no request
+	// the host makes in reaction to a callback can reach a system any sooner. A closed-loop host, whose next
+	// request depends on when the callbacks arrive, needs this to see the right queue depth and latency.
+	// With open_loop set, the workers simulate a window while the host moves on to the next one, and callbacks
+	// arrive up to two quanta late. This is only for hosts whose requests don't depend on the callbacks, which
+	// can then also pass a large quantum so that handing windows over costs little next to simulating them.
+	// DMA through the host memory callback is not supported, since it would run on the worker threads.
+	class PCI_SSD_Group
+	{
+		public:
+		PCI_SSD_Group(uint num_systems, uint first_id, Config config, uint64_t quantum = 0, bool open_loop = false);
+		~PCI_SSD_Group();
+		bool addTransaction(uint system, bool isWrite, uint64_t addr, int num_sectors, uint qos_class = 0);
+		void update();
+		void RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone);
+		void printLogfile(ostream &out);
+
+		// Simulate every system up to the current host cycle and deliver their completions.
+		void Sync();
+
+		// Internal functions
+		void Start_Window();
+		void Finish_Window();
+
+		TransactionCompleteCB *ReadDone;
+		TransactionCompleteCB *WriteDone;
+
+		vector<GroupWorker *> workers;
+		uint64_t quantum;
+		bool open_loop; // The host doesn't wait for a window before starting on the next one.
+		uint64_t currentClockCycle; // Host cycles so far.
+		uint64_t window_start; // Host cycle the window being filled started on.
+		bool window_running; // A window has been handed to the workers and not collected yet.
+	};
+}
+
+#endif
@@ -29,53 +29,89 @@
 *********************************************************************************/
 
 #include "PCI_SSD_System.h"
+#include "Checkpoint.h"
 
 using namespace std;
 
 namespace PCISSD
 {
-	PCI_SSD_System::PCI_SSD_System(uint id)
+	// Checkpoint files start with this tag and version. Bump the version whenever the saved state changes.
+	static const char CHECKPOINT_TAG[8] = {'P', 'C', 'I', 'S', 'S', 'D', 'C', 'P'};
+	static const uint64_t CHECKPOINT_VERSION = 6;
+
+	PCI_SSD_System::PCI_SSD_System(uint id, string ini_file)
+	{
+		// Start from the config.h defaults and apply the ini file on top of them.
+		if (!ini_file.empty())
+			config.Load(ini_file);
+
+		Init(id);
+	}
+
+	PCI_SSD_System::PCI_SSD_System(uint id, Config config)
+	{
+		this->config = config;
+
+		Init(id);
+	}
+
+	void PCI_SSD_System::Init(uint id)
 	{
+		config.Validate();
+
 		cerr << "PCI_SSD id is " << id << "\n";
 
-		debug_file.open(DEBUG_FILE, ios_base::out | ios_base::trunc);
-		if (!debug_file.is_open())
+		// Every instance gets its own debug file, so instances with different ids never share one.
+		if (DEBUG)
 		{
-			cerr << "ERROR: Debug file " << DEBUG_FILE << " failed to open.\n";
-			abort();
+			string debug_name = DEBUG_FILE;
+			size_t pos = debug_name.find("%i");
+			if (pos != string::npos)
+				debug_name.replace(pos, 2, to_string((unsigned long long)id));
+
+			debug_file.open(debug_name.c_str(), ios_base::out | ios_base::trunc);
+			if (!debug_file.is_open())
+			{
+				cerr << "ERROR: Debug file " << debug_name << " failed to open.\n";
+				abort();
+			}
+		}
+
+		if (DEBUG)
+		{
+			debug_file << "PCI_SSD configuration:\n";
+			config.Print(debug_file);
+			debug_file << "\n";
+			debug_file.flush();
 		}
 
 		systemID = id;
-		hybridsim = HybridSim::getMemorySystemInstance(0, HYBRIDSIM_INI);
+
+		num_devices = config.num_devices;
+		stripe_sectors = config.stripe_size / SECTOR_SIZE;
 
 		currentClockCycle = 0;
 
+		stats = new Stats(config.stats_window, config.steady_windows, config.steady_threshold, config.stats_confidence);
+		profiler = new Profiler(config.enable_profile);
+
 		// Set up clock domain crosser.
 		ClockDomain::ClockUpdateCB *cd_callback = new ClockDomain::Callback<PCI_SSD_System, void>(this, &PCI_SSD_System::update_internal);
-		clockdomain = new ClockDomain::ClockDomainCrosser(INTERNAL_CLOCK, EXTERNAL_CLOCK, cd_callback);
-
-		// Register callbacks to HybridSim.
-		typedef HybridSim::Callback <PCI_SSD_System, void, uint, uint64_t, uint64_t> hybridsim_callback_t;
-        HybridSim::TransactionCompleteCB *read_cb = new hybridsim_callback_t(this, &PCI_SSD_System::HybridSim_Read_Callback);
-        HybridSim::TransactionCompleteCB *write_cb = new hybridsim_callback_t(this, &PCI_SSD_System::HybridSim_Write_Callback);
-		hybridsim->RegisterCallbacks(read_cb, write_cb);
-
-		// Set up HybridSim's clock domain.
-		ClockDomain::ClockUpdateCB *hybridsim_cd_callback = new ClockDomain::Callback<PCI_SSD_System, void>(this, &PCI_SSD_System::hybridsim_update_internal);
-		hybridsim_clockdomain = new ClockDomain::ClockDomainCrosser(HYBRIDSIM_CLOCK_1, HYBRIDSIM_CLOCK_2, hybridsim_cd_callback);
+		clockdomain = new ClockDomain::ClockDomainCrosser(config.internal_clock, config.external_clock, cd_callback);
 
 		// Set up layers.
-		layer1 = new Layer(this, LAYER1_DATA_DELAY, LAYER1_COMMAND_DELAY, LAYER1_LANES, LAYER1_FULL_DUPLEX, LAYER1_SEND_EVENT, LAYER1_RETURN_EVENT, "Layer 1");
-		layer2 = new Layer(this, LAYER2_DATA_DELAY, LAYER2_COMMAND_DELAY, LAYER2_LANES, LAYER2_FULL_DUPLEX, LAYER2_SEND_EVENT, LAYER2_RETURN_EVENT, "Layer 2");
-		if (DEBUG)
+		Build_Topology(config.topology);
+
+		// Set up the devices. Each one has its own backend, cache and prefetcher.
+		for (uint k=0; k < num_devices; k++)
 		{
-			debug_file << "Layer 1 delays are (data: " << LAYER1_DATA_DELAY << ", command: " << LAYER1_COMMAND_DELAY << ")\n";
-			debug_file << "Layer 2 delays are (data: " << LAYER2_DATA_DELAY << ", command: " << LAYER2_COMMAND_DELAY << ")\n";
-			debug_file.flush();
+			devices.push_back(new SSD_Device(this, k));
 		}
 
 		// Make sure the add_dma callback is NULL before it is registered.
 		add_dma = NULL;
+		dma_memory_size = 0;
+		dma_outstanding = 0;
 	}
 
 	PCI_SSD_System::~PCI_SSD_System()
@@ -87,18 +123,21 @@ namespace PCISSD
 		}
 
 		delete clockdomain;
-		delete hybridsim_clockdomain;
-		delete layer1;
-		delete layer2;
-		delete hybridsim;
+		delete stats;
+		delete profiler;
+		for (uint l=0; l < layers.size(); l++)
+			delete layers[l];
+		for (uint k=0; k < num_devices; k++)
+			delete devices[k];
 	}
 
 
-	bool PCI_SSD_System::addTransaction(bool isWrite, uint64_t addr, int num_sectors)
+	bool PCI_SSD_System::addTransaction(bool isWrite, uint64_t addr, int num_sectors, uint qos_class)
 	{
 		// Make sure I know the range of the number of sectors being transferred.
 		assert(num_sectors >= MIN_SECTORS);	
 		assert(num_sectors <= MAX_SECTORS);
+		assert(qos_class < NUM_QOS_CLASSES);
 
 		// Make sure any sectors in this transaction aren't already being processed.
 		// This is just going to fail an assert for now. I can fix it later if we ever have a user doing this.
@@ -116,7 +155,7 @@ namespace PCISSD
 		if (DEBUG)
 		{
 			debug_file << currentClockCycle << ": Sector addTransaction() arrived (isWrite: " << isWrite 
-					<< ", addr: " << addr << ", num_sectors: " << num_sectors << ")\n";
+					<< ", addr: " << addr << ", num_sectors: " << num_sectors << ", qos_class: " << qos_class << ")\n";
 			debug_file.flush();
 
 			if (aligned_sector_addr != addr)
@@ -131,6 +170,8 @@ namespace PCISSD
 		// Create the transaction and place it in the Layer 1 Send Queue.
 		Transaction t(isWrite, aligned_sector_addr, addr, num_sectors, dma_sg_base, dma_sg_len);
 		//Transaction t(isWrite, aligned_sector_addr, addr, num_sectors);
+		t.issue_time = currentClockCycle;
+		t.qos_class = qos_class;
 
 		// Clear the scatter gather list for the next transaction.
 		dma_sg_base.clear();
@@ -138,18 +179,62 @@ namespace PCISSD
 		dma_sg_all.clear();
 
 		// Check for DMA for write transaction.
-		if ((ENABLE_DMA) && (isWrite))
+		if ((config.enable_dma) && (isWrite))
 		{
 			PerformDMA(t);
 		}
 		else
 		{
-			layer1->Add_Send_Transaction(t);
+			layers[0]->Add_Send_Transaction(t);
 		}
 
 		return true;
 	}
 
+
+	void PCI_SSD_System::addFunctionalTransaction(bool isWrite, uint64_t addr, int num_sectors)
+	{
+		assert(num_sectors >= MIN_SECTORS);	
+		assert(num_sectors <= MAX_SECTORS);
+
+		// The same rule as addTransaction(): a sector that is still being processed can't be touched.
+		uint64_t aligned_sector_addr = SECTOR_ALIGN(addr); 
+		for (uint64_t i=0; i < (uint64_t)num_sectors; i++)
+		{
+			assert(pending_sectors.count(aligned_sector_addr + i * SECTOR_SIZE) == 0);
+		}
+
+		list<uint64_t> empty;
+		Transaction t(isWrite, aligned_sector_addr, addr, num_sectors, empty, empty);
+		t.issue_time = currentClockCycle;
+		if (num_devices == 1)
+		{
+			devices[0]->Functional_Access(t);
+			return;
+		}
+
+		// Split into stripe pieces the same way as Stripe_Transaction() and hand each one to its device.
+		uint64_t first_sector = aligned_sector_addr / SECTOR_SIZE;
+		uint64_t end_sector = first_sector + num_sectors;
+		uint64_t cur_sector = first_sector;
+		while (cur_sector < end_sector)
+		{
+			uint64_t stripe = cur_sector / stripe_sectors;
+			uint64_t offset = cur_sector % stripe_sectors;
+			uint64_t piece_sectors = min(stripe_sectors - offset, end_sector - cur_sector);
+
+			uint64_t device_addr = ((stripe / num_devices) * stripe_sectors + offset) * SECTOR_SIZE;
+			Transaction piece(isWrite, device_addr, device_addr, piece_sectors, empty, empty);
+			piece.device = stripe % num_devices;
+			piece.issue_time = t.issue_time;
+			piece.qos_class = t.qos_class;
+
+			devices[piece.device]->Functional_Access(piece);
+
+			cur_sector += piece_sectors;
+		}
+	}
+
 	
 	bool PCI_SSD_System::WillAcceptTransaction()
 	{
@@ -166,7 +251,171 @@ namespace PCISSD
 
 	void PCI_SSD_System::printLogfile()
 	{
-		hybridsim->printLogfile();
+		printLogfile(cout);
+	}
+
+	void PCI_SSD_System::printLogfile(ostream &out)
+	{
+		stats->Print_Stats(out);
+		profiler->Print_Stats(out, currentClockCycle);
+
+		for (uint l=0; l < layers.size(); l++)
+			layers[l]->Print_Stats(out);
+
+		for (uint k=0; k < num_devices; k++)
+		{
+			if (num_devices > 1)
+				out << "PCI_SSD device " << k << ":\n";
+
+			devices[k]->printLogfile(out);
+		}
+	}
+
+	void PCI_SSD_System::SaveCheckpoint(string filename)
+	{
+		ofstream out(filename.c_str(), ios_base::out | ios_base::trunc | ios_base::binary);
+		if (!out.is_open())
+		{
+			cerr << "ERROR: Checkpoint file " << filename << " failed to open.\n";
+			abort();
+		}
+
+		Save(out);
+
+		out.close();
+		if (out.fail())
+		{
+			cerr << "ERROR: Failed to write checkpoint file " << filename << ".\n";
+			abort();
+		}
+
+		if (DEBUG)
+		{
+			debug_file << currentClockCycle << " : Saved checkpoint to " << filename << "\n";
+			debug_file.flush();
+		}
+	}
+
+	void PCI_SSD_System::RestoreCheckpoint(string filename)
+	{
+		ifstream in(filename.c_str(), ios_base::in | ios_base::binary);
+		if (!in.is_open())
+		{
+			cerr << "ERROR: Checkpoint file " << filename << " failed to open.\n";
+			abort();
+		}
+
+		Restore(in);
+
+		if (DEBUG)
+		{
+			debug_file << currentClockCycle << " : Restored checkpoint from " << filename << "\n";
+			debug_file.flush();
+		}
+	}
+
+	void PCI_SSD_System::Save(ostream &out)
+	{
+		// The config is saved so that Restore() can refuse a checkpoint from a different configuration.
+		stringstream settings;
+		config.Print(settings);
+
+		out.write(CHECKPOINT_TAG, sizeof(CHECKPOINT_TAG));
+		save_value(out, CHECKPOINT_VERSION);
+		save_value(out, settings.str());
+
+		save_value(out, currentClockCycle);
+		save_value(out, clockdomain->counter1);
+		save_value(out, clockdomain->counter2);
+
+		save_value(out, pending_sectors);
+		save_value(out, event_queue);
+		save_value(out, stripe_transactions);
+		save_value(out, stripe_pieces);
+
+		save_value(out, dma_transactions);
+		save_value(out, dma_accesses);
+		save_value(out, dma_base_address);
+		save_value(out, dma_sg_base);
+		save_value(out, dma_sg_len);
+		save_value(out, dma_sg_all);
+		save_value(out, dma_queue);
+		save_value(out, dma_outstanding);
+
+		stats->Save(out);
+
+		for (uint l=0; l < layers.size(); l++)
+			layers[l]->Save(out);
+
+		for (uint k=0; k < num_devices; k++)
+			devices[k]->Save(out);
+	}
+
+	void PCI_SSD_System::Restore(istream &in)
+	{
+		char tag[sizeof(CHECKPOINT_TAG)];
+		uint64_t version = 0;
+		string saved_settings;
+
+		in.read(tag, sizeof(tag));
+		restore_value(in, version);
+		if ((!in.good()) || (string(tag, sizeof(tag)) != string(CHECKPOINT_TAG, sizeof(CHECKPOINT_TAG))) || (version != CHECKPOINT_VERSION))
+		{
+			cerr << "ERROR: Not a version " << CHECKPOINT_VERSION << " PCI_SSD checkpoint.\n";
+			abort();
+		}
+
+		// Every parameter has to match, since the state only makes sense for the links and devices it was saved from.
+		restore_value(in, saved_settings);
+		stringstream settings;
+		config.Print(settings);
+		if (saved_settings != settings.str())
+		{
+			cerr << "ERROR: Checkpoint was saved with a different configuration. Saved configuration:\n" << saved_settings;
+			abort();
+		}
+
+		restore_value(in, currentClockCycle);
+		restore_value(in, clockdomain->counter1);
+		restore_value(in, clockdomain->counter2);
+
+		restore_value(in, pending_sectors);
+		restore_value(in, event_queue);
+		restore_value(in, stripe_transactions);
+		restore_value(in, stripe_pieces);
+
+		restore_value(in, dma_transactions);
+		restore_value(in, dma_accesses);
+		restore_value(in, dma_base_address);
+		restore_value(in, dma_sg_base);
+		restore_value(in, dma_sg_len);
+		restore_value(in, dma_sg_all);
+		restore_value(in, dma_queue);
+		restore_value(in, dma_outstanding);
+
+		stats->Restore(in);
+
+		for (uint l=0; l < layers.size(); l++)
+			layers[l]->Restore(in);
+
+		for (uint k=0; k < num_devices; k++)
+			devices[k]->Restore(in);
+
+		if (!in.good())
+		{
+			cerr << "ERROR: Checkpoint is truncated.\n";
+			abort();
+		}
+	}
+
+	bool PCI_SSD_System::isSteadyState()
+	{
+		return stats->Steady();
+	}
+
+	bool PCI_SSD_System::isConverged()
+	{
+		return stats->Converged();
 	}
 
 	// DMA functions
@@ -350,69 +599,63 @@ namespace PCISSD
 
 
 	// Internal functions
-	void PCI_SSD_System::HybridSim_Read_Callback(uint id, uint64_t addr, uint64_t cycle)
-	{
-		handle_hybridsim_callback(false, addr);
-	}
-
-
-	void PCI_SSD_System::HybridSim_Write_Callback(uint id, uint64_t addr, uint64_t cycle)
-	{
-		handle_hybridsim_callback(true, addr);
-	}
-
-
 	void PCI_SSD_System::update()
 	{
+		ProfileScope scope(profiler, PROFILE_UPDATE);
+
 		clockdomain->update();
 	}
 
 	void PCI_SSD_System::update_internal()
 	{
-		// Do Processing for layer 2
-		layer2->update();
-
-		// Do processing for layer 1
-		layer1->update();
+		// Do processing for the layers, starting at the devices and working up to the host.
+		{
+			ProfileScope scope(profiler, PROFILE_LAYERS);
+			for (int l=layers.size()-1; l >= 0; l--)
+				layers[l]->update();
+		}
 
 		// Do processing for event queue
-		Process_Event_Queue();
+		{
+			ProfileScope scope(profiler, PROFILE_EVENTS);
+			Process_Event_Queue();
+		}
 
 		// Do processing for dma_queue.
-		UpdateDMA();
+		{
+			ProfileScope scope(profiler, PROFILE_DMA);
+			UpdateDMA();
+		}
 
-		// Call update for HybridSim.
-		// This uses a clock domain crosser due to the different clock rates.
-		// The callback is hybridsim_update_internal.
-		hybridsim_clockdomain->update();
+		// Do processing for the devices (cache destage engines and backends).
+		{
+			ProfileScope scope(profiler, PROFILE_DEVICES);
+			for (uint k=0; k < num_devices; k++)
+				devices[k]->update();
+		}
 
 		// Increment clock cycle counter.
 		currentClockCycle++;
 
+		stats->Update(currentClockCycle);
+
 		if (DEBUG)
 		{
 			if (currentClockCycle % 10000 == 0)
 			{
-				debug_file << currentClockCycle << " : length(event_queue)=" << event_queue.size() 
-						<< " length(layer1.send_queue)=" << layer1->send_queue.size() 
-						<< " length(layer1.return_queue)=" << layer1->return_queue.size()
-						<< " length(layer2.send_queue)=" << layer2->send_queue.size()
-						<< " length(layer2.return_queue)=" << layer2->return_queue.size() << "\n";
+				debug_file << currentClockCycle << " : length(event_queue)=" << event_queue.size();
+				for (uint l=0; l < layers.size(); l++)
+				{
+					debug_file << " length(" << layers[l]->layer_name << ".send_queue)=" << layers[l]->send_queue.size()
+							<< " length(" << layers[l]->layer_name << ".return_queue)=" << layers[l]->return_queue.size();
+				}
+				debug_file << "\n";
 				debug_file.flush();
 			}
 		}
 	}
 
 
-	void PCI_SSD_System::hybridsim_update_internal()
-	{
-		// Call HybridSim at the appropriate clock rate.
-		// Ratio of call is HYBRIDSIM_CLOCK_1 : HYBRIDSIM_CLOCK_2
-		hybridsim->update();
-	}
-
-
-
 	// Event Queue Implementation
 	void PCI_SSD_System::Process_Event_Queue()
 	{
@@ -420,22 +663,27 @@ namespace PCISSD
 		{
 			TransactionEvent e = event_queue.front();
 			event_queue.pop_front();
+			profiler->events++;
 
-			if (e.type == LAYER1_SEND_EVENT)
+			if (e.type == LAYER_SEND_EVENT)
+			{
+				Layer_Send_Event_Done(e);
+			}
+			else if (e.type == LAYER_RETURN_EVENT)
 			{
-				Layer1_Send_Event_Done(e);
+				Layer_Return_Event_Done(e);
 			}
-			else if (e.type == LAYER1_RETURN_EVENT)
+			else if (e.type == CACHE_HIT_EVENT)
 			{
-				Layer1_Return_Event_Done(e);
+				Cache_Hit_Event_Done(e);
 			}
-			else if (e.type == LAYER2_SEND_EVENT)
+			else if (e.type == PREFETCH_HIT_EVENT)
 			{
-				Layer2_Send_Event_Done(e);
+				Prefetch_Hit_Event_Done(e);
 			}
-			else if (e.type == LAYER2_RETURN_EVENT)
+			else if (e.type == CONTROLLER_RETRY_EVENT)
 			{
-				Layer2_Return_Event_Done(e);
+				Controller_Retry_Event_Done(e);
 			}
 			else
 				assert(0);
@@ -459,189 +707,364 @@ namespace PCISSD
 	}
 
 
-	void PCI_SSD_System::Layer1_Send_Event_Done(TransactionEvent e)
+	void PCI_SSD_System::Build_Topology(string topology)
 	{
-		assert(e.type == LAYER1_SEND_EVENT);
+		if (strip(topology).empty())
+		{
+			// Default topology: one Layer 1 link from the host and one Layer 2 link per device.
+			Add_Layer("Layer 1", config.layer1_type, config.layer1_lanes, config.layer1_full_duplex, config.layer1_merge, -1);
+			for (uint k=0; k < num_devices; k++)
+			{
+				stringstream name;
+				name << "Layer 2";
+				if (num_devices > 1)
+					name << " (device " << k << ")";
+				Add_Layer(name.str(), config.layer2_type, config.layer2_lanes, config.layer2_full_duplex, config.layer2_merge, 0);
+			}
+		}
+		else
+		{
+			unordered_map<string, int> layer_index;
+			list<string> links = split(strip(topology));
+			for (list<string>::iterator it = links.begin(); it != links.end(); it++)
+			{
+				vector<string> fields;
+				list<string> split_link = split(*it, ":");
+				fields.assign(split_link.begin(), split_link.end());
+				if ((fields.size() != 5) && (fields.size() != 6))
+				{
+					cerr << "ERROR: Invalid link in TOPOLOGY: " << *it << " (expected name:type:lanes:duplex:parent[:merge])\n";
+					abort();
+				}
 
-		layer1->Send_Event_Done(e.trans);
+				string name = fields[0];
+				uint64_t lanes, full_duplex, merge = 0;
+				convert_uint64_t(lanes, fields[2], name);
+				convert_uint64_t(full_duplex, fields[3], name);
+				if (fields.size() == 6)
+					convert_uint64_t(merge, fields[5], name);
 
-		layer2->Add_Send_Transaction(e.trans);
-	}
+				if ((lanes == 0) || (lanes > 16) || ((lanes & (lanes - 1)) != 0))
+				{
+					cerr << "ERROR: Link " << name << " in TOPOLOGY has " << lanes << " lanes (must be 1, 2, 4, 8 or 16).\n";
+					abort();
+				}
 
-	void PCI_SSD_System::Layer1_Return_Event_Done(TransactionEvent e)
-	{
-		assert(e.type == LAYER1_RETURN_EVENT);
+				if (layer_index.count(name) != 0)
+				{
+					cerr << "ERROR: Link " << name << " is listed twice in TOPOLOGY.\n";
+					abort();
+				}
+
+				int parent_layer = -1;
+				if (fields[4] != "host")
+				{
+					if (layer_index.count(fields[4]) == 0)
+					{
+						cerr << "ERROR: Parent " << fields[4] << " of link " << name << " must be listed before it in TOPOLOGY.\n";
+						abort();
+					}
+					parent_layer = layer_index[fields[4]];
+				}
+				else if (!layers.empty())
+				{
+					cerr << "ERROR: TOPOLOGY must have exactly one root link, and it must be listed first.\n";
+					abort();
+				}
 
-		layer1->Return_Event_Done(e.trans);
+				layer_index[name] = layers.size();
+				Add_Layer(name, interface_type(fields[1]), lanes, full_duplex, merge, parent_layer);
+			}
+		}
 
-		// Remove from the pending_sectors set.
-		uint64_t aligned_sector_addr = SECTOR_ALIGN(e.trans.addr);
-		assert(aligned_sector_addr == e.trans.addr); // Just confirm that the address was aligned.
-		for (uint64_t i=0; i < (uint64_t)e.trans.num_sectors; i++)
+		// Devices attach to the links with no children, in the order they were listed.
+		vector<bool> has_children(layers.size(), false);
+		for (uint l=1; l < layers.size(); l++)
+			has_children[layer_parent[l]] = true;
+		for (uint l=0; l < layers.size(); l++)
 		{
-			// Remove from the pending_sectors set.
-			uint64_t cur_sector = aligned_sector_addr + i * SECTOR_SIZE;
-			assert(pending_sectors.count(cur_sector) == 1);
-			pending_sectors.erase(cur_sector);
-			assert(pending_sectors.count(cur_sector) == 0);
+			if (!has_children[l])
+				device_layer.push_back(l);
+		}
+		if (device_layer.size() != num_devices)
+		{
+			cerr << "ERROR: TOPOLOGY has " << device_layer.size() << " device links but NUM_DEVICES is " << num_devices << ".\n";
+			abort();
 		}
 
-		// Check for DMA Write for SSD reads.
-		if ((ENABLE_DMA) && (!e.trans.isWrite))
+		// Build the routing table by walking up from each device to the root.
+		layer_route.assign(layers.size(), vector<uint>(num_devices, 0));
+		for (uint k=0; k < num_devices; k++)
 		{
-			PerformDMA(e.trans);
+			uint cur = device_layer[k];
+			layer_route[cur][k] = cur;
+			while (layer_parent[cur] != -1)
+			{
+				layer_route[layer_parent[cur]][k] = cur;
+				cur = layer_parent[cur];
+			}
+			assert(cur == 0);
 		}
-		else
+	}
+
+
+	void PCI_SSD_System::Add_Layer(string name, uint64_t type, uint64_t lanes, bool full_duplex, bool merge, int parent_layer)
+	{
+		assert((lanes == 1) || (lanes == 2) || (lanes == 4) || (lanes == 8) || (lanes == 16));
+		assert(parent_layer < (int)layers.size());
+		assert((parent_layer == -1) == layers.empty());
+
+		LinkModel *link = new LinkModel(type, lanes, config);
+		layers.push_back(new Layer(this, layers.size(), link, full_duplex, merge, name));
+		layer_parent.push_back(parent_layer);
+
+		if (DEBUG)
 		{
-			// Issue the external callback.
-			// Use the orig_addr since this is the unaligned original address that the caller expects.
-			issue_external_callback(e.trans.isWrite, e.trans.orig_addr);
+			debug_file << name << " transfer times in ps are (command: " << link->Command_Time() 
+					<< ", 4 KB write: " << link->Data_Time(4096, true) << ", 4 KB read: " << link->Data_Time(4096, false) << ")\n";
+			debug_file.flush();
 		}
 	}
 
 
-	void PCI_SSD_System::Layer2_Send_Event_Done(TransactionEvent e)
+	void PCI_SSD_System::Layer_Send_Event_Done(TransactionEvent e)
 	{
-		assert(e.type == LAYER2_SEND_EVENT);
+		assert(e.type == LAYER_SEND_EVENT);
+		assert(e.layer < layers.size());
 
-		layer2->Send_Event_Done(e.trans);
+		// With NCQ, a write stays on the link until its data has been sent.
+		if (!layers[e.layer]->Send_Event_Done(e.trans))
+			return;
 
-		handle_hybridsim_add_transaction(e.trans);
+		// Host transactions are split across the devices once they leave the root link.
+		if (e.layer == 0)
+			Stripe_Transaction(e.trans);
+		else
+			Forward_Transaction(e.layer, e.trans);
 	}
 
 
-	void PCI_SSD_System::Layer2_Return_Event_Done(TransactionEvent e)
+	void PCI_SSD_System::Layer_Return_Event_Done(TransactionEvent e)
 	{
-		assert(e.type == LAYER2_RETURN_EVENT);
+		assert(e.type == LAYER_RETURN_EVENT);
+		assert(e.layer < layers.size());
 
-		layer2->Return_Event_Done(e.trans);
+		layers[e.layer]->Return_Event_Done(e.trans);
 
-		layer1->Add_Return_Transaction(e.trans);
+		if (e.layer == 0)
+		{
+			if (e.trans.merged.empty())
+			{
+				Complete_Host_Transaction(e.trans);
+			}
+			else
+			{
+				// Split a merged transaction back into the originals so each caller gets its own completion.
+				for (list<Transaction>::iterator it = e.trans.merged.begin(); it != e.trans.merged.end(); it++)
+				{
+					Complete_Host_Transaction(*it);
+				}
+			}
+		}
+		else if ((layer_parent[e.layer] == 0) && (num_devices > 1))
+		{
+			// Stripe pieces have to be joined back together before they cross the root link.
+			// Links below may have merged pieces of different host transactions.
+			if (e.trans.merged.empty())
+			{
+				Stripe_Piece_Done(e.trans);
+			}
+			else
+			{
+				for (list<Transaction>::iterator it = e.trans.merged.begin(); it != e.trans.merged.end(); it++)
+				{
+					Stripe_Piece_Done(*it);
+				}
+			}
+		}
+		else
+		{
+			layers[layer_parent[e.layer]]->Add_Return_Transaction(e.trans);
+		}
 	}
 
 
-	void PCI_SSD_System::handle_hybridsim_callback(bool isWrite, uint64_t addr)
+	void PCI_SSD_System::Forward_Transaction(uint layer, Transaction t)
 	{
-		if (DEBUG)
+		assert(t.device < num_devices);
+
+		// Either hand the transaction to the next link towards its device or to the device itself.
+		uint next = layer_route[layer][t.device];
+		if (next == layer)
+			Device_Access(t);
+		else
+			layers[next]->Add_Send_Transaction(t);
+	}
+
+
+	void PCI_SSD_System::Complete_Host_Transaction(Transaction t)
+	{
+		// Remove from the pending_sectors set.
+		uint64_t aligned_sector_addr = SECTOR_ALIGN(t.addr);
+		assert(aligned_sector_addr == t.addr); // Just confirm that the address was aligned.
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
 		{
-			debug_file << currentClockCycle << " : Received callback from HybridSim (" << isWrite << ", " << addr << ")\n";
-			debug_file.flush();
+			// Remove from the pending_sectors set.
+			uint64_t cur_sector = aligned_sector_addr + i * SECTOR_SIZE;
+			assert(pending_sectors.count(cur_sector) == 1);
+			pending_sectors.erase(cur_sector);
+			assert(pending_sectors.count(cur_sector) == 0);
 		}
 
-		// Compute the base address.
-		assert(hybridsim_base_address.count(addr) == 1);
-		uint64_t base_address = hybridsim_base_address[addr];
-		hybridsim_base_address.erase(addr);
-		assert(hybridsim_base_address.count(addr) == 0);
+		// Check for DMA Write for SSD reads.
+		if ((config.enable_dma) && (!t.isWrite))
+		{
+			PerformDMA(t);
+		}
+		else
+		{
+			// Issue the external callback.
+			// Use the orig_addr since this is the unaligned original address that the caller expects.
+			issue_external_callback(t);
+		}
+	}
 
-		// Check that this address is in the pending state for HybridSim.
-		assert(hybridsim_transactions.count(base_address) == 1);
-		assert(hybridsim_accesses.count(base_address) == 1);
 
-		// Get the transaction
-		Transaction old_t = hybridsim_transactions[base_address];
-		assert(isWrite == old_t.isWrite);
-		assert(base_address == old_t.addr);
+	void PCI_SSD_System::Stripe_Transaction(Transaction t)
+	{
+		// A single device sees host addresses unchanged.
+		if (num_devices == 1)
+		{
+			t.device = 0;
+			Forward_Transaction(0, t);
+			return;
+		}
+
+		// Split the transaction at stripe boundaries and send each piece to its device.
+		// Piece addresses are local to the device, so the devices see dense address spaces.
+		uint64_t first_sector = t.addr / SECTOR_SIZE;
+		uint64_t end_sector = first_sector + t.num_sectors;
 
-		// Remove current address from the access set for the base address.
-		assert(hybridsim_accesses[base_address].count(addr) == 1);
-		hybridsim_accesses[base_address].erase(addr);
-		assert(hybridsim_accesses[base_address].count(addr) == 0);
+		assert(stripe_transactions.count(t.addr) == 0);
+		stripe_transactions[t.addr] = t;
+		stripe_pieces[t.addr] = 0;
 
-		
-		// If the whole sector transaction is done, then send it back up.
-		if (hybridsim_accesses[base_address].empty())
+		uint64_t cur_sector = first_sector;
+		while (cur_sector < end_sector)
 		{
+			uint64_t stripe = cur_sector / stripe_sectors;
+			uint64_t offset = cur_sector % stripe_sectors;
+			uint64_t piece_sectors = min(stripe_sectors - offset, end_sector - cur_sector);
+
+			uint64_t device_addr = ((stripe / num_devices) * stripe_sectors + offset) * SECTOR_SIZE;
+			list<uint64_t> empty;
+			Transaction piece(t.isWrite, device_addr, device_addr, piece_sectors, empty, empty, t.origin);
+			piece.device = stripe % num_devices;
+			piece.parent_addr = t.addr;
+			// Pieces are scheduled on their own below the stripe point, so they carry the host request's class and age.
+			piece.issue_time = t.issue_time;
+			piece.qos_class = t.qos_class;
+
 			if (DEBUG)
 			{
-				debug_file << currentClockCycle << " : Finished HybridSim transactions for base address " << base_address << "\n";
+				debug_file << currentClockCycle << " : Striping (" << t.isWrite << ", " << t.addr << ") piece " << stripe_pieces[t.addr]
+						<< " to device " << piece.device << " at " << device_addr << " (" << piece_sectors << " sectors)\n";
 				debug_file.flush();
 			}
 
-			// Create a Transaction for the return path.
-			// Not reusing old_t since it should be deleted by the pending state cleanup.
-			// The only thing I need from old_t is the orig_addr (which is the address before SECTOR_ALIGN()).
-			//Transaction t(isWrite, base_address, old_t.orig_addr, old_t.num_sectors, old_t.dma_sg_base, old_t.dma_sg_len);
-			//Transaction t(isWrite, base_address, old_t.orig_addr, old_t.num_sectors);
-			Transaction t = old_t; // Make a deep copy.
+			stripe_pieces[t.addr]++;
+			Forward_Transaction(0, piece);
+
+			cur_sector += piece_sectors;
+		}
+	}
 
-			// Remove the pending state.
-			hybridsim_transactions.erase(base_address);
-			hybridsim_accesses.erase(base_address);
 
-			// Check that the pending state is cleared.
-			assert(hybridsim_transactions.count(base_address) == 0);
-			assert(hybridsim_accesses.count(base_address) == 0);
+	void PCI_SSD_System::Stripe_Piece_Done(Transaction t)
+	{
+		assert(stripe_pieces.count(t.parent_addr) == 1);
+		assert(stripe_pieces[t.parent_addr] > 0);
+		stripe_pieces[t.parent_addr]--;
 
-			// Put transaction in appropriate return queue.
-			layer2->Add_Return_Transaction(t);
+		if (stripe_pieces[t.parent_addr] == 0)
+		{
+			// Every piece is back, so the original host transaction can go back up the root link.
+			Transaction parent_t = stripe_transactions[t.parent_addr];
+			stripe_transactions.erase(t.parent_addr);
+			stripe_pieces.erase(t.parent_addr);
+
+			layers[0]->Add_Return_Transaction(parent_t);
 		}
 	}
 
 
-	void PCI_SSD_System::handle_hybridsim_add_transaction(Transaction t)
+	void PCI_SSD_System::Device_Access(Transaction t)
 	{
-		// This code sends out HYBRIDSIM_TRANSACTIONS(num_sectors) transactions for each sector,
-		// since HybridSim transactions are at a smaller granularity than a sector.
-		// The base address for all transactions is the aligned sector address.
-		uint64_t base_address = t.addr;
+		SSD_Device *device = devices[t.device];
 
-		// Assert that there is not an outstanding access to this sector.
-		assert(hybridsim_transactions.count(base_address) == 0);
-		assert(hybridsim_accesses.count(base_address) == 0);
+		// Let the prefetcher see every demand read once, when it first reaches the controller.
+		if ((config.enable_prefetch) && (!t.isWrite))
+		{
+			device->prefetcher->Train(t);
+		}
 
-		// Create entries for this sector access.
-		hybridsim_transactions[base_address] = t; // Save the transaction object for use by the callback.
-		hybridsim_accesses[base_address] = set<uint64_t>(); // Empty set for the outstanding HybridSim accesses.
+		device->Access(t);
+	}
 
-		// I like assertions. They prevent migraines.
-		assert(hybridsim_transactions.count(base_address) == 1);
-		assert(hybridsim_accesses.count(base_address) == 1);
 
+	void PCI_SSD_System::Device_Transaction_Done(Transaction t)
+	{
+		// Put transaction in the return queue of the device's link.
+		assert(t.device < num_devices);
+		layers[device_layer[t.device]]->Add_Return_Transaction(t);
+	}
 
-		// Add HYBRIDSIM_TRANSACTIONS(num_sectors) transactions to HybridSim.
-		for (uint64_t i = 0; i < (uint64_t)HYBRIDSIM_TRANSACTIONS(t.num_sectors); i++)
-		{
-			uint64_t cur_address = base_address + i * HYBRIDSIM_TRANSACTION_SIZE;
 
-			// Save this access in the access list for this base address.
-			hybridsim_accesses[base_address].insert(cur_address);
+	void PCI_SSD_System::Cache_Hit_Event_Done(TransactionEvent e)
+	{
+		assert(e.type == CACHE_HIT_EVENT);
 
-			// Save the mapping from this access to the current base address.
-			// This is necessary because of the variable sized transactions do not allow for an easy
-			// way to compute the base address from the access address.
-			assert(hybridsim_base_address.count(cur_address) == 0);
-			hybridsim_base_address[cur_address] = base_address;
-			assert(hybridsim_base_address.count(cur_address) == 1);
+		// The cache answered this transaction, so it goes straight back up.
+		Device_Transaction_Done(e.trans);
+	}
 
-			// Send this transaction to HybridSim.
-			bool success = hybridsim->addTransaction(t.isWrite, cur_address);
-			assert(success); // HybridSim::addTransaction should never fail since it just returns true. :)
-		}
 
+	void PCI_SSD_System::Prefetch_Hit_Event_Done(TransactionEvent e)
+	{
+		assert(e.type == PREFETCH_HIT_EVENT);
 
-		if (DEBUG)
-		{
-			debug_file << currentClockCycle << " : Added " << HYBRIDSIM_TRANSACTIONS(t.num_sectors) << " to HybridSim for base address " << base_address << "\n";
-			debug_file.flush();
-		}
+		// The prefetch buffer answered this transaction, so it goes straight back up.
+		Device_Transaction_Done(e.trans);
 	}
 
 
-	void PCI_SSD_System::issue_external_callback(bool isWrite, uint64_t orig_addr)
+	void PCI_SSD_System::Controller_Retry_Event_Done(TransactionEvent e)
+	{
+		assert(e.type == CONTROLLER_RETRY_EVENT);
+
+		devices[e.trans.device]->Access(e.trans);
+	}
+
+
+	void PCI_SSD_System::issue_external_callback(Transaction t)
 	{
 		if (DEBUG)
 		{
-			debug_file << currentClockCycle << " : Issuing external callback for transaction (" << isWrite << ", " << orig_addr << ")\n";
+			debug_file << currentClockCycle << " : Issuing external callback for transaction (" << t.isWrite << ", " << t.orig_addr << ")\n";
 			debug_file.flush();
 		}
 
+		stats->Complete(t.isWrite, t.qos_class, currentClockCycle - t.issue_time);
+
 		// Select the appropriate callback method pointer.
-		TransactionCompleteCB *cb = isWrite ? WriteDone : ReadDone;
+		TransactionCompleteCB *cb = t.isWrite ? WriteDone : ReadDone;
 
 		// Call the callback if it is not null.
 		if (cb != NULL)
-			(*cb)(systemID, orig_addr, currentClockCycle);
+		{
+			ProfileScope scope(profiler, PROFILE_CALLBACKS);
+			(*cb)(systemID, t.orig_addr, currentClockCycle);
+		}
 	}
 
 	void PCI_SSD_System::PerformDMA(Transaction t)
@@ -727,7 +1150,7 @@ namespace PCISSD
 			// For an SSD write, we perform a DMA read.
 			// After the DMA read completes, it is time to send the transaction across the host
 			// interface and down to the disk.
-			layer1->Add_Send_Transaction(t);
+			layers[0]->Add_Send_Transaction(t);
 		}
 		else
 		{
@@ -736,7 +1159,7 @@ namespace PCISSD
 
 			// Issue the external callback.
 			// Use the orig_addr since this is the unaligned original address that the caller expects.
-			issue_external_callback(t.isWrite, t.orig_addr);
+			issue_external_callback(t);
 		}
 	}
 
@@ -746,7 +1169,7 @@ namespace PCISSD
 		// Only send MAX_DMA_PENDING transactions at once to DRAMSim so as not to overflow the marss 
 		// pending memory request queue (which can happen if marss memory requests are stalled due to 
 		// contention from the DMA requests.
-		if ((dma_outstanding < MAX_PENDING_DMA) && (!dma_queue.empty()))
+		if ((dma_outstanding < config.max_pending_dma) && (!dma_queue.empty()))
 		{
 			// Get the DMA request at the front of the dma_queue.
 			pair<bool, uint64_t> cur_dma = dma_queue.front();
@@ -755,10 +1178,13 @@ namespace PCISSD
 			uint64_t cur_addr = cur_dma.second;
 			
 			// Send the DMA request to DRAMSim.
-			(*add_dma)(isWrite, cur_addr, 0); // Send the transaction to DRAMSim via the add_dma callback.
+			{
+				ProfileScope scope(profiler, PROFILE_CALLBACKS);
+				(*add_dma)(isWrite, cur_addr, 0); // Send the transaction to DRAMSim via the add_dma callback.
+			}
 			dma_outstanding++;
 
-			if (dma_outstanding == MAX_PENDING_DMA)
+			if (dma_outstanding == config.max_pending_dma)
 			{
 				if (DEBUG)
 				{
@@ -775,24 +1201,9 @@ namespace PCISSD
 		return new PCI_SSD_System(id);
 	}
 
-	// Helper function to compute the delay in nanoseconds of a layer interface.
-	uint64_t compute_interface_delay(uint64_t num_bytes, uint64_t bytes_per_second, uint64_t efficiency)
+	PCI_SSD_System *getInstance(uint id, string ini_file)
 	{
-		if (bytes_per_second == 0)
-		{
-			// For the NONE case.
-			return 0;
-		}
-		else
-		{
-			double efficiency_percentage = double(efficiency) / 100.0;
-			double total_bytes = (double)(num_bytes) / efficiency_percentage;
-			double in_seconds = total_bytes / (double)(bytes_per_second);
-			double in_nanoseconds = in_seconds * 1000000000;
-			return (uint64_t)ceil(in_nanoseconds);
-		}
+		return new PCI_SSD_System(id, ini_file);
 	}
 
 }
-
-
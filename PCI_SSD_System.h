@@ -32,22 +32,35 @@
 #ifndef PCI_SSD_SYSTEM_H
 #define PCI_SSD_SYSTEM_H
 
+#include "Config.h"
 #include "Layer.h"
+#include "SSD_Device.h"
+#include "Stats.h"
+#include "Profile.h"
 #include "common.h"
 #include "config.h"
 
 namespace PCISSD
 {
+	// Thread safety: every PCI_SSD_System is self-contained. It owns its config, debug file (named from its id),
+	// links, devices, backends and stats, and the library keeps no global state. Different instances can be
+	// driven from different threads at the same time, provided they have different ids and use the flash
+	// backend (HybridSim is not thread safe). A single instance is not thread safe, so all calls to it must
+	// come from one thread at a time. Callbacks run on the thread that calls update().
 	class PCI_SSD_System
 	{
 		public:
-		PCI_SSD_System(uint id);
+		PCI_SSD_System(uint id, string ini_file = "");
+		PCI_SSD_System(uint id, Config config);
 		~PCI_SSD_System();
-		bool addTransaction(bool isWrite, uint64_t addr, int num_sectors);
+		// qos_class runs from 0 (most important) to NUM_QOS_CLASSES-1. Links use it to schedule (see LAYER_SCHEDULER in config.h).
+		bool addTransaction(bool isWrite, uint64_t addr, int num_sectors, uint qos_class = 0);
+		void addFunctionalTransaction(bool isWrite, uint64_t addr, int num_sectors);
 		bool WillAcceptTransaction();
 		void update();
 		void RegisterCallbacks(TransactionCompleteCB *readDone, TransactionCompleteCB *writeDone);
 		void printLogfile();
+		void printLogfile(ostream &out);
 
 		// DMA functions
 		void RegisterDMACallback(DMATransactionCB *add_dma, uint64_t mem_size);
@@ -55,28 +68,44 @@ namespace PCISSD
 		void CompleteDMATransaction(bool isWrite, uint64_t addr);
 		void AddDMAScatterGatherEntry(uint64_t addr, uint64_t length);
 
-		// Internal functions
-		void HybridSim_Read_Callback(uint id, uint64_t addr, uint64_t cycle);
-		void HybridSim_Write_Callback(uint id, uint64_t addr, uint64_t cycle);
+		// Statistics functions
+		bool isSteadyState();
+		bool isConverged();
 
+		// Checkpoint functions
+		void SaveCheckpoint(string filename);
+		void RestoreCheckpoint(string filename);
+		void Save(ostream &out);
+		void Restore(istream &in);
 
+		// Internal functions
+		void Init(uint id);
 		void update_internal();
-		void hybridsim_update_internal();
 
 		void Process_Event_Queue();
 		void Add_Event(TransactionEvent e);
 		void Retry_Event(TransactionEvent e);
 
-		void Layer1_Send_Event_Done(TransactionEvent e);
-		void Layer1_Return_Event_Done(TransactionEvent e);
+		// Topology functions
+		void Build_Topology(string topology);
+		void Add_Layer(string name, uint64_t type, uint64_t lanes, bool full_duplex, bool merge, int parent_layer);
+
+		void Layer_Send_Event_Done(TransactionEvent e);
+		void Layer_Return_Event_Done(TransactionEvent e);
+		void Forward_Transaction(uint layer, Transaction t);
+		void Complete_Host_Transaction(Transaction t);
 
-		void Layer2_Send_Event_Done(TransactionEvent e);
-		void Layer2_Return_Event_Done(TransactionEvent e);
+		void Stripe_Transaction(Transaction t);
+		void Stripe_Piece_Done(Transaction t);
 
-		void handle_hybridsim_add_transaction(Transaction t);
-		void handle_hybridsim_callback(bool isWrite, uint64_t addr);
+		void Device_Access(Transaction t);
+		void Device_Transaction_Done(Transaction t);
 
-		void issue_external_callback(bool isWrite, uint64_t orig_addr);
+		void Cache_Hit_Event_Done(TransactionEvent e);
+		void Prefetch_Hit_Event_Done(TransactionEvent e);
+		void Controller_Retry_Event_Done(TransactionEvent e);
+
+		void issue_external_callback(Transaction t);
 
 		// Internal DMA functions
 		void PerformDMA(Transaction t);
@@ -89,24 +118,32 @@ namespace PCISSD
         TransactionCompleteCB *WriteDone;
 		uint systemID;
 
+		// Settings for this instance. num_devices and stripe_sectors are copied out of it for the hot paths.
+		Config config;
+		uint num_devices;
+		uint64_t stripe_sectors;
+
 		uint64_t currentClockCycle;
 		ClockDomain::ClockDomainCrosser *clockdomain;
 
-		HybridSim::HybridSystem *hybridsim;
-		ClockDomain::ClockDomainCrosser *hybridsim_clockdomain;
-
-		// State to save while HybridSim is doing its thing.
-		unordered_map<uint64_t, Transaction> hybridsim_transactions; // Outstanding sector transactions.
-		unordered_map<uint64_t, set<uint64_t>> hybridsim_accesses; // Outstanding acceses to HybridSim for each sector.
-		unordered_map<uint64_t, uint64_t> hybridsim_base_address; // Base address for an outstanding access.
-
 		set<uint64_t> pending_sectors; // Simple rule: only one instance of each address at a time, otherwise, this is an error.
 
 		list<TransactionEvent> event_queue;
 
-		Layer *layer1;
+		// Interconnect topology. layers[0] is the root link to the host, and parents come before children.
+		vector<Layer *> layers;
+		vector<int> layer_parent; // Upstream link of each link (-1 for the root).
+		vector<vector<uint>> layer_route; // layer_route[l][d] is the next link from l towards device d (l itself at the device).
+		vector<uint> device_layer; // Link each device is attached to.
+
+		vector<SSD_Device *> devices;
 
-		Layer *layer2;
+		// Host transactions that were split across devices, and the number of pieces still outstanding.
+		unordered_map<uint64_t, Transaction> stripe_transactions;
+		unordered_map<uint64_t, uint64_t> stripe_pieces;
+
+		Stats *stats; // Host request latency and throughput.
+		Profiler *profiler; // Host time spent in each part of the simulator.
 
 		ofstream debug_file;
 
@@ -135,8 +172,7 @@ namespace PCISSD
 	};
 
 	PCI_SSD_System *getInstance(uint id);
-
-	uint64_t compute_interface_delay(uint64_t num_bytes, uint64_t bytes_per_second, uint64_t efficiency);
+	PCI_SSD_System *getInstance(uint id, string ini_file);
 }
 
 #endif
@@ -0,0 +1,83 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Profile.h"
+
+namespace PCISSD
+{
+	static const char *PROFILE_NAMES[NUM_PROFILE_SECTIONS] = 
+	{
+		"update()",
+		"layers",
+		"event queue",
+		"DMA",
+		"devices",
+		"backend",
+		"host callbacks"
+	};
+
+	Profiler::Profiler(bool enabled)
+	{
+		this->enabled = enabled;
+
+		for (uint i=0; i < NUM_PROFILE_SECTIONS; i++)
+		{
+			time[i] = 0;
+			calls[i] = 0;
+		}
+		events = 0;
+	}
+
+	void Profiler::Print_Stats(ostream &out, uint64_t cycles)
+	{
+		if (!enabled)
+			return;
+
+		double seconds = time[PROFILE_UPDATE] / 1e9;
+		double total = max(time[PROFILE_UPDATE], (uint64_t)1);
+
+		out << "PCI_SSD profile: " << seconds << " s in update() for " << cycles << " cycles (" 
+				<< (seconds > 0 ? cycles / seconds : 0) << " cycles/s), " << events << " events (" 
+				<< (seconds > 0 ? events / seconds : 0) << " events/s)\n";
+
+		// The backend runs inside the devices. Host callbacks may also run outside update() (DMA completions).
+		for (uint i=PROFILE_LAYERS; i < NUM_PROFILE_SECTIONS; i++)
+		{
+			out << "\t" << PROFILE_NAMES[i] << ": " << time[i] / 1e9 << " s (" << 100.0 * time[i] / total << "%), " 
+					<< calls[i] << " calls\n";
+		}
+
+		// Clock domain crossing, stats and the update() calls themselves.
+		uint64_t parts = time[PROFILE_LAYERS] + time[PROFILE_EVENTS] + time[PROFILE_DMA] + time[PROFILE_DEVICES];
+		uint64_t other = (time[PROFILE_UPDATE] > parts) ? time[PROFILE_UPDATE] - parts : 0;
+		out << "\tother: " << other / 1e9 << " s (" << 100.0 * other / total << "%)\n";
+	}
+}
@@ -0,0 +1,96 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_PROFILE_H
+#define PCI_SSD_PROFILE_H
+
+#include <chrono>
+
+#include "common.h"
+
+namespace PCISSD
+{
+	enum ProfileSection
+	{
+		PROFILE_UPDATE,
+		PROFILE_LAYERS,
+		PROFILE_EVENTS,
+		PROFILE_DMA,
+		PROFILE_DEVICES,
+		PROFILE_BACKEND,
+		PROFILE_CALLBACKS,
+		NUM_PROFILE_SECTIONS
+	};
+
+	// Host wall clock time the simulator spends in each of its parts, to guide optimization work.
+	// Sections nest (the backend runs inside the devices, and host callbacks inside whatever finished the
+	// request), so every time is inclusive. When disabled, a section costs one branch.
+	class Profiler
+	{
+		public:
+		Profiler(bool enabled);
+
+		void Print_Stats(ostream &out, uint64_t cycles);
+
+		bool enabled;
+		uint64_t time[NUM_PROFILE_SECTIONS]; // ns
+		uint64_t calls[NUM_PROFILE_SECTIONS];
+		uint64_t events; // Events taken off the event queue.
+	};
+
+	// Times the scope it is declared in and adds the time to a section of the profiler.
+	class ProfileScope
+	{
+		public:
+		ProfileScope(Profiler *profiler, ProfileSection section)
+		{
+			this->profiler = profiler;
+			this->section = section;
+			if (profiler->enabled)
+				start = chrono::steady_clock::now();
+		}
+
+		~ProfileScope()
+		{
+			if (profiler->enabled)
+			{
+				profiler->time[section] += chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+				profiler->calls[section]++;
+			}
+		}
+
+		Profiler *profiler;
+		ProfileSection section;
+		chrono::steady_clock::time_point start;
+	};
+}
+
+#endif
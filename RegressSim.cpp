@@ -0,0 +1,632 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+// Determinism regression driver.
+// Replays the traces in traces/ and a set of generated workloads against the stub backend (BACKEND_STUB),
+// and checks the completion cycle of every request against golden files. Any change to the timing of
+// the simulator shows up as a difference, so refactors of the hot paths can be checked to be exact.
+//
+// Usage: PCI_SSD_Regress [-u] [-d DIR] [CASE ...]
+//     -u      write the golden files from this build instead of checking against them
+//     -d DIR  directory of the golden files (default: regress)
+// With no CASE names, every case runs. Each golden file is DIR/CASE.txt, with one line per completion in
+// completion order (see SweepRun.h). Returns nonzero if any case differs from its golden file or has none.
+// The cross checks (see CHECKS below) also run, unless -u is given or CASE names are given without them.
+// "make regress" builds this and checks every case.
+
+#include "SweepRun.h"
+#include "PCI_SSD_Group.h"
+#include "PCI_SSD_Async.h"
+#include <algorithm>
+#include <unordered_map>
+
+using namespace std;
+using namespace PCISSD;
+
+class RegressCase
+{
+	public:
+	const char *name;
+	const char *workload; // Workload spec (see Workload.h).
+	uint64_t queue_depth;
+	uint64_t sg_entry_size; // Bytes per SG entry, or 0 for no DMA.
+	const char *settings; // Space separated KEY=VALUE settings on top of the defaults.
+};
+
+// Sizes are in sectors, so 8 is 4 KB, 256 is 128 KB and 2048 is 1 MB.
+const RegressCase CASES[] =
+{
+	{"trace_aggressive", "trace:traces/aggressive.txt", 32, 0, ""},
+	{"trace_fail_overlap", "trace:traces/fail_overlap.txt", 32, 0, ""},
+	{"trace_overlap", "trace:traces/overlap.txt", 32, 0, ""},
+	{"trace_test", "trace:traces/test.txt", 32, 0, ""},
+	{"rand_4k_mixed", "random:2000:70:8", 32, 0, ""},
+	{"seq_write_128k", "sequential:300:0:256", 8, 0, ""},
+	{"rand_1m_mixed", "random:100:50:2048", 4, 0, ""},
+	{"dma_sg_64k", "random:300:50:128", 16, 4096, ""},
+	{"cache_prefetch_seq", "sequential:2000:80:8", 16, 0, "ENABLE_CACHE=1 ENABLE_PREFETCH=1"},
+	{"two_devices", "random:1000:70:16", 32, 0, "NUM_DEVICES=2 STRIPE_SIZE=4096"},
+	{"cache_large_writes", "random:60:30:2048", 4, 0, "ENABLE_CACHE=1 CACHE_SIZE=4194304"},
+	{"qos_wfq_mixed", "mixed:300:70:8:256", 32, 0, "LAYER_SCHEDULER=WFQ"},
+	{"qos_deadline_striped", "mixed:300:70:8:256", 32, 0, "NUM_DEVICES=2 STRIPE_SIZE=4096 LAYER_SCHEDULER=DEADLINE"},
+	{"merge_shared_switch", "sequential:600:70:8", 32, 0, "NUM_DEVICES=2 STRIPE_SIZE=4096 TOPOLOGY=up:PCI3:8:1:host sw:PCI3:8:1:up:1 ssd0:SATA3:1:0:sw ssd1:SATA3:1:0:sw"},
+	{"ncq_shared_sata", "sequential:600:50:8", 32, 0, "NUM_DEVICES=2 STRIPE_SIZE=4096 TOPOLOGY=up:PCI3:8:1:host sw:SATA3:1:0:up ssd0:PCI3:4:1:sw ssd1:PCI3:4:1:sw"},
+};
+const uint64_t NUM_CASES = sizeof(CASES) / sizeof(CASES[0]);
+
+enum CheckDriver
+{
+	CHECK_GROUP, // A PCI_SSD_Group against the same systems updated one after another on this thread.
+	CHECK_ASYNC, // A PCI_SSD_Async against a plain PCI_SSD_System.
+	CHECK_CHECKPOINT // Systems restored into new instances from a checkpoint halfway through, against uninterrupted ones.
+};
+
+// A cross check runs one workload two ways that must agree on timing, and compares the two completion logs
+// with each other instead of with a golden file. It also checks that the second way delivers every callback
+// no earlier than the first, and no later than it promises (see CheckOutput). Requests are issued open loop, request i on external cycle
+// i * gap and to system i % systems, so the issue cycles don't depend on when the callbacks arrive. Requests
+// that touch a sector a recent request touched are dropped, since they could be issued while it is in flight.
+// With sg_entry_size set, requests move their data by DMA, which needs a single system. PCI_SSD_Async hands
+// DMA requests to the host ASYNC_HORIZON cycles late, so the plain system's host memory answers that much later.
+class CrossCheck
+{
+	public:
+	const char *name;
+	CheckDriver driver;
+	const char *workload;
+	uint64_t gap;
+	uint64_t systems;
+	uint64_t sg_entry_size; // Bytes per SG entry, or 0 for no DMA.
+	const char *settings;
+};
+
+const CrossCheck CHECKS[] =
+{
+	{"group_vs_serial", CHECK_GROUP, "sequential:400:70:16", 300, 4, 0, ""},
+	{"async_vs_system", CHECK_ASYNC, "sequential:400:70:16", 300, 1, 0, ""},
+	{"async_dma_vs_system", CHECK_ASYNC, "sequential:300:50:64", 1000, 1, 4096, ""},
+	{"checkpoint_cache_prefetch", CHECK_CHECKPOINT, "random:400:50:8:524288", 5000, 1, 0, "ENABLE_CACHE=1 ENABLE_PREFETCH=1 CACHE_SIZE=262144"},
+	{"checkpoint_sata_dma", CHECK_CHECKPOINT, "sequential:300:50:64", 1000, 1, 4096, "LAYER2_TYPE=SATA3"},
+	{"checkpoint_striped_wfq", CHECK_CHECKPOINT, "mixed:300:70:8:256", 1000, 2, 0, "NUM_DEVICES=2 STRIPE_SIZE=4096 LAYER_SCHEDULER=WFQ"},
+	{"checkpoint_flow_control", CHECK_CHECKPOINT, "sequential:400:50:32", 300, 1, 0, "PCIE_FLOW_CONTROL=1"},
+	{"checkpoint_aspm", CHECK_CHECKPOINT, "sequential:200:50:32", 40000, 1, 0, "PCIE_FLOW_CONTROL=1 ENABLE_ASPM=1"},
+};
+const uint64_t NUM_CHECKS = sizeof(CHECKS) / sizeof(CHECKS[0]);
+
+// Host memory answers DMA accesses after this many external cycles.
+const uint64_t HOST_DELAY = 50;
+
+const uint64_t ASYNC_HORIZON = 1024;
+
+// Requests to the same sector are issued at least this many external cycles apart, which is well past the
+// latency of any request in the cross checks.
+const uint64_t OVERLAP_CYCLES = 100000;
+
+// Returns the config for a case's settings, on the stub backend.
+Config case_config(const char *case_settings)
+{
+	// Words without an '=' continue the previous value, so settings like TOPOLOGY can contain spaces.
+	list<pair<string, string> > values;
+	list<string> settings = split(case_settings);
+	for (list<string>::iterator it = settings.begin(); it != settings.end(); it++)
+	{
+		if (it->empty())
+			continue;
+		size_t pos = it->find("=");
+		if (pos == string::npos)
+		{
+			assert(!values.empty());
+			values.back().second += " " + *it;
+		}
+		else
+			values.push_back(make_pair(it->substr(0, pos), it->substr(pos+1)));
+	}
+
+	Config config;
+	for (list<pair<string, string> >::iterator it = values.begin(); it != values.end(); it++)
+		config.Set(it->first, it->second);
+	config.Set("BACKEND_TYPE", "STUB");
+	config.Validate();
+
+	return config;
+}
+
+// Returns the completion log of one case.
+string run_case(const RegressCase &c)
+{
+	Config config = case_config(c.settings);
+
+	Workload workload;
+	workload.Parse(c.workload);
+
+	stringstream log;
+	SweepRun run(0, config, &workload, c.queue_depth);
+	run.sg_entry_size = c.sg_entry_size;
+	run.host_delay = HOST_DELAY;
+	run.completion_log = &log;
+	run.Run();
+
+	return log.str();
+}
+
+// What one side of a cross check saw.
+class CheckOutput
+{
+	public:
+	CheckOutput()
+	{
+		lateness = 0;
+	}
+
+	string log; // "system_id address isWrite completion_cycle" lines, in delivery order.
+	vector<uint64_t> delivered; // Host cycle each line's callback arrived on.
+	uint64_t lateness; // Host cycles the callbacks may arrive after the completion.
+};
+
+// Host side of a cross check. Issues the requests, collects the completions and models host memory for DMA.
+class CheckHost
+{
+	public:
+	CheckHost(const CrossCheck &c, const Workload *workload, uint64_t host_delay) :
+		read_cb(this, &CheckHost::read_complete), write_cb(this, &CheckHost::write_complete), dma_cb(this, &CheckHost::dma_request)
+	{
+		assert((c.sg_entry_size == 0) || (c.systems == 1));
+
+		this->c = c;
+		this->workload = workload;
+		this->host_delay = host_delay;
+		cycle = 0;
+		next = 0;
+		completions = 0;
+	}
+
+	// Every request gets a host buffer of its own, twice its size, so its SG entries can leave gaps.
+	uint64_t Buffer_Size()
+	{
+		return 2 * MAX_SECTORS * SECTOR_SIZE;
+	}
+
+	bool Done()
+	{
+		return completions == workload->ops.size();
+	}
+
+	void read_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		output.log += to_string(id) + " " + to_string(addr) + " 0 " + to_string(clock_cycle) + "\n";
+		output.delivered.push_back(cycle);
+		completions++;
+	}
+
+	void write_complete(uint id, uint64_t addr, uint64_t clock_cycle)
+	{
+		output.log += to_string(id) + " " + to_string(addr) + " 1 " + to_string(clock_cycle) + "\n";
+		output.delivered.push_back(cycle);
+		completions++;
+	}
+
+	void dma_request(uint isWrite, uint64_t addr, uint64_t unused)
+	{
+		HostAccess a;
+		a.done_cycle = cycle + host_delay;
+		a.isWrite = isWrite;
+		a.addr = addr;
+		accesses.push_back(a);
+	}
+
+	CrossCheck c;
+	const Workload *workload;
+	uint64_t host_delay;
+	uint64_t cycle; // Host cycle being run.
+	uint64_t next; // Next request to issue.
+	list<HostAccess> accesses; // DMA accesses in flight, in completion order.
+	CheckOutput output;
+	uint64_t completions;
+
+	Callback<CheckHost, void, uint, uint64_t, uint64_t> read_cb;
+	Callback<CheckHost, void, uint, uint64_t, uint64_t> write_cb;
+	Callback<CheckHost, void, uint, uint64_t, uint64_t> dma_cb;
+};
+
+// Points a system's callbacks at the host. System is PCI_SSD_System or PCI_SSD_Async, which take the same calls.
+template <class System>
+void attach_system(System *system, CheckHost &host)
+{
+	system->RegisterCallbacks(&host.read_cb, &host.write_cb);
+	if (host.c.sg_entry_size != 0)
+		system->RegisterDMACallback(&host.dma_cb, host.workload->ops.size() * host.Buffer_Size());
+}
+
+// Runs the host and systems, updated one after another on this thread, until every request has completed or
+// end_cycle is reached. It can be called again to carry on from where it stopped.
+template <class System>
+void run_systems(const vector<System *> &systems, CheckHost &host, uint64_t end_cycle)
+{
+	const CrossCheck &c = host.c;
+	assert(systems.size() == c.systems);
+
+	const vector<WorkloadOp> &ops = host.workload->ops;
+	for (; (!host.Done()) && (host.cycle < end_cycle); host.cycle++)
+	{
+		while ((!host.accesses.empty()) && (host.accesses.front().done_cycle <= host.cycle))
+		{
+			systems[0]->CompleteDMATransaction(host.accesses.front().isWrite, host.accesses.front().addr);
+			host.accesses.pop_front();
+		}
+
+		while ((host.next < ops.size()) && (host.next * c.gap == host.cycle))
+		{
+			const WorkloadOp &op = ops[host.next];
+			System *mem = systems[host.next % c.systems];
+			if (c.sg_entry_size != 0)
+			{
+				uint64_t bytes = op.num_sectors * SECTOR_SIZE;
+				for (uint64_t offset=0; offset < bytes; offset += c.sg_entry_size)
+					mem->AddDMAScatterGatherEntry(host.next * host.Buffer_Size() + 2 * offset, min(c.sg_entry_size, bytes - offset));
+			}
+			mem->addTransaction(op.isWrite, op.addr, op.num_sectors, op.qos_class);
+			host.next++;
+		}
+
+		for (uint64_t s=0; s < c.systems; s++)
+			systems[s]->update();
+	}
+}
+
+// Runs a cross check on plain PCI_SSD_Systems. Host memory answers DMA accesses host_delay cycles after they are made.
+CheckOutput run_serial(const CrossCheck &c, const Config &config, const Workload &workload, uint64_t host_delay)
+{
+	CheckHost host(c, &workload, host_delay);
+
+	// Use the ids a PCI_SSD_Group would give the systems, since they show up in the log.
+	vector<PCI_SSD_System *> systems;
+	for (uint64_t s=0; s < c.systems; s++)
+	{
+		systems.push_back(new PCI_SSD_System(s * config.num_devices, config));
+		attach_system(systems[s], host);
+	}
+
+	run_systems(systems, host, UINT64_MAX);
+
+	for (uint64_t s=0; s < c.systems; s++)
+		delete systems[s];
+
+	return host.output;
+}
+
+// Runs a cross check on plain PCI_SSD_Systems, but moves every system into a new instance through a checkpoint
+// on host cycle checkpoint_cycle.
+CheckOutput run_checkpointed(const CrossCheck &c, const Config &config, const Workload &workload, uint64_t checkpoint_cycle)
+{
+	CheckHost host(c, &workload, HOST_DELAY);
+
+	vector<PCI_SSD_System *> systems;
+	for (uint64_t s=0; s < c.systems; s++)
+	{
+		systems.push_back(new PCI_SSD_System(s * config.num_devices, config));
+		attach_system(systems[s], host);
+	}
+
+	run_systems(systems, host, checkpoint_cycle);
+
+	for (uint64_t s=0; s < c.systems; s++)
+	{
+		stringstream checkpoint;
+		systems[s]->Save(checkpoint);
+		delete systems[s];
+
+		systems[s] = new PCI_SSD_System(s * config.num_devices, config);
+		attach_system(systems[s], host);
+		systems[s]->Restore(checkpoint);
+	}
+
+	run_systems(systems, host, UINT64_MAX);
+
+	for (uint64_t s=0; s < c.systems; s++)
+		delete systems[s];
+
+	return host.output;
+}
+
+// Runs a cross check on a PCI_SSD_Async.
+CheckOutput run_async(const CrossCheck &c, const Config &config, const Workload &workload)
+{
+	assert(c.systems == 1);
+
+	CheckHost host(c, &workload, HOST_DELAY);
+	PCI_SSD_Async async(0, config, ASYNC_HORIZON);
+	attach_system(&async, host);
+
+	vector<PCI_SSD_Async *> systems(1, &async);
+	run_systems(systems, host, UINT64_MAX);
+
+	host.output.lateness = ASYNC_HORIZON;
+	return host.output;
+}
+
+// Runs a cross check on a PCI_SSD_Group with its default, closed-loop windows.
+CheckOutput run_group(const CrossCheck &c, const Config &config, const Workload &workload)
+{
+	assert(c.sg_entry_size == 0);
+
+	CheckHost host(c, &workload, 0);
+	PCI_SSD_Group group(c.systems, 0, config);
+	group.RegisterCallbacks(&host.read_cb, &host.write_cb);
+
+	const vector<WorkloadOp> &ops = workload.ops;
+	for (; !host.Done(); host.cycle++)
+	{
+		while ((host.next < ops.size()) && (host.next * c.gap == host.cycle))
+		{
+			const WorkloadOp &op = ops[host.next];
+			group.addTransaction(host.next % c.systems, op.isWrite, op.addr, op.num_sectors, op.qos_class);
+			host.next++;
+		}
+
+		group.update();
+	}
+
+	host.output.lateness = group.quantum;
+	return host.output;
+}
+
+// Drops the requests that touch a sector a request issued less than OVERLAP_CYCLES earlier touched, since
+// that one could still be in flight. Requests are issued every gap cycles.
+void drop_overlaps(Workload &workload, uint64_t gap)
+{
+	unordered_map<uint64_t, uint64_t> last_issue; // Sector address to the cycle its last request was issued.
+	vector<WorkloadOp> ops;
+	for (uint64_t i=0; i < workload.ops.size(); i++)
+	{
+		const WorkloadOp &op = workload.ops[i];
+		uint64_t issue_cycle = ops.size() * gap;
+		bool overlap = false;
+		for (uint64_t k=0; k < op.num_sectors; k++)
+		{
+			unordered_map<uint64_t, uint64_t>::iterator it = last_issue.find(SECTOR_ALIGN(op.addr) + k * SECTOR_SIZE);
+			if ((it != last_issue.end()) && (issue_cycle - it->second < OVERLAP_CYCLES))
+				overlap = true;
+		}
+		if (overlap)
+			continue;
+
+		for (uint64_t k=0; k < op.num_sectors; k++)
+			last_issue[SECTOR_ALIGN(op.addr) + k * SECTOR_SIZE] = issue_cycle;
+		ops.push_back(op);
+	}
+	workload.ops = ops;
+}
+
+// Runs both sides of a cross check. Returns the names of the two sides in name_a and name_b.
+void run_check(const CrossCheck &c, CheckOutput &output_a, CheckOutput &output_b, string &name_a, string &name_b)
+{
+	Config config = case_config(c.settings);
+
+	Workload workload;
+	workload.Parse(c.workload);
+	drop_overlaps(workload, c.gap);
+
+	if (c.driver == CHECK_GROUP)
+	{
+		name_a = "serial";
+		name_b = "group";
+		output_a = run_serial(c, config, workload, HOST_DELAY);
+		output_b = run_group(c, config, workload);
+	}
+	else if (c.driver == CHECK_ASYNC)
+	{
+		name_a = "system";
+		name_b = "async";
+		output_a = run_serial(c, config, workload, HOST_DELAY + ASYNC_HORIZON);
+		output_b = run_async(c, config, workload);
+	}
+	else
+	{
+		// Checkpoint on an odd cycle halfway through the requests, so that some of them are in flight.
+		assert(c.driver == CHECK_CHECKPOINT);
+		name_a = "uninterrupted";
+		name_b = "restored";
+		output_a = run_serial(c, config, workload, HOST_DELAY);
+		output_b = run_checkpointed(c, config, workload, (workload.ops.size() / 2) * c.gap + c.gap / 2 + 1);
+	}
+}
+
+// Returns the number of the first completion that b delivers before a does or more than b.lateness cycles
+// after, or 0 if there is none. a and b must have the same completions.
+uint64_t late_delivery(const CheckOutput &a, const CheckOutput &b)
+{
+	assert(a.delivered.size() == b.delivered.size());
+	for (uint64_t i=0; i < a.delivered.size(); i++)
+	{
+		if ((b.delivered[i] < a.delivered[i]) || (b.delivered[i] > a.delivered[i] + b.lateness))
+			return i + 1;
+	}
+	return 0;
+}
+
+// Returns the line number of the first line where a and b differ, or 0 if they are the same.
+uint64_t first_difference(const string &a, const string &b, string &line_a, string &line_b)
+{
+	stringstream in_a(a), in_b(b);
+	uint64_t line = 0;
+	while (true)
+	{
+		line++;
+		bool more_a = (bool)getline(in_a, line_a);
+		bool more_b = (bool)getline(in_b, line_b);
+		if (!more_a)
+			line_a = "(end of output)";
+		if (!more_b)
+			line_b = "(end of output)";
+		if ((!more_a) && (!more_b))
+			return 0;
+		if ((!more_a) || (!more_b) || (line_a != line_b))
+			return line;
+	}
+}
+
+void usage()
+{
+	cerr << "Usage: PCI_SSD_Regress [-u] [-d DIR] [CASE ...]\n";
+	cerr << "Cases:";
+	for (uint64_t i=0; i < NUM_CASES; i++)
+		cerr << " " << CASES[i].name;
+	cerr << "\n";
+	cerr << "Cross checks:";
+	for (uint64_t i=0; i < NUM_CHECKS; i++)
+		cerr << " " << CHECKS[i].name;
+	cerr << "\n";
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	bool update = false;
+	string golden_dir = "regress";
+	vector<const RegressCase *> selected;
+	vector<const CrossCheck *> selected_checks;
+
+	for (int i=1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if (arg == "-u")
+			update = true;
+		else if ((arg == "-d") && (i+1 < argc))
+			golden_dir = argv[++i];
+		else
+		{
+			uint64_t c = 0;
+			while ((c < NUM_CASES) && (arg != CASES[c].name))
+				c++;
+			uint64_t k = 0;
+			while ((k < NUM_CHECKS) && (arg != CHECKS[k].name))
+				k++;
+			if (c < NUM_CASES)
+				selected.push_back(&CASES[c]);
+			else if (k < NUM_CHECKS)
+				selected_checks.push_back(&CHECKS[k]);
+			else
+				usage();
+		}
+	}
+
+	if ((selected.empty()) && (selected_checks.empty()))
+	{
+		for (uint64_t c=0; c < NUM_CASES; c++)
+			selected.push_back(&CASES[c]);
+		for (uint64_t k=0; k < NUM_CHECKS; k++)
+			selected_checks.push_back(&CHECKS[k]);
+	}
+
+	// Cross checks have no golden files to write.
+	if (update)
+		selected_checks.clear();
+
+	uint64_t failures = 0;
+	for (uint64_t i=0; i < selected.size(); i++)
+	{
+		const RegressCase &c = *selected[i];
+		string output = run_case(c);
+		uint64_t completions = count(output.begin(), output.end(), '\n');
+		string golden_file = golden_dir + "/" + c.name + ".txt";
+
+		if (update)
+		{
+			ofstream out(golden_file.c_str(), ios_base::out | ios_base::trunc);
+			if (!out.is_open())
+			{
+				cerr << "ERROR: Failed to open " << golden_file << "\n";
+				abort();
+			}
+			out << output;
+			cout << "Regress: " << c.name << " wrote " << completions << " completions to " << golden_file << "\n";
+			continue;
+		}
+
+		ifstream in(golden_file.c_str());
+		if (!in.is_open())
+		{
+			cout << "Regress: " << c.name << " FAILED (no golden file " << golden_file << ")\n";
+			failures++;
+			continue;
+		}
+		stringstream golden;
+		golden << in.rdbuf();
+
+		string line_a, line_b;
+		uint64_t line = first_difference(golden.str(), output, line_a, line_b);
+		if (line == 0)
+			cout << "Regress: " << c.name << " ok (" << completions << " completions)\n";
+		else
+		{
+			cout << "Regress: " << c.name << " FAILED at line " << line << " of " << golden_file << "\n";
+			cout << "\texpected: " << line_a << "\n";
+			cout << "\tgot:      " << line_b << "\n";
+			failures++;
+		}
+	}
+
+	for (uint64_t i=0; i < selected_checks.size(); i++)
+	{
+		const CrossCheck &c = *selected_checks[i];
+		CheckOutput output_a, output_b;
+		string name_a, name_b;
+		run_check(c, output_a, output_b, name_a, name_b);
+		uint64_t completions = output_a.delivered.size();
+
+		string line_a, line_b;
+		uint64_t line = first_difference(output_a.log, output_b.log, line_a, line_b);
+		uint64_t late = (line == 0) ? late_delivery(output_a, output_b) : 0;
+		if ((line == 0) && (late == 0))
+			cout << "Regress: " << c.name << " ok (" << completions << " completions)\n";
+		else if (line != 0)
+		{
+			cout << "Regress: " << c.name << " FAILED at completion " << line << "\n";
+			cout << "\t" << name_a << ": " << line_a << "\n";
+			cout << "\t" << name_b << ": " << line_b << "\n";
+			failures++;
+		}
+		else
+		{
+			cout << "Regress: " << c.name << " FAILED at completion " << late << ": delivered on host cycle " 
+					<< output_b.delivered[late-1] << " by " << name_b << " and " << output_a.delivered[late-1] << " by " << name_a
+					<< " (at most " << output_b.lateness << " cycles late)\n";
+			failures++;
+		}
+	}
+
+	if (failures != 0)
+	{
+		cout << "Regress: " << failures << " of " << selected.size() + selected_checks.size() << " cases FAILED\n";
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,93 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_SPSCRING_H
+#define PCI_SSD_SPSCRING_H
+
+#include <atomic>
+#include <vector>
+#include <stdint.h>
+#include <assert.h>
+
+namespace PCISSD
+{
+	// Bounded lock-free queue between exactly one producer thread and one consumer thread.
+	// Capacity is rounded up to a power of two. Push() fails when the ring is full and Pop() when it is empty.
+	template <typename T>
+	class SPSCRing
+	{
+		public:
+		SPSCRing(uint64_t capacity) : head(0), tail(0)
+		{
+			assert(capacity > 0);
+			uint64_t size = 1;
+			while (size < capacity)
+				size *= 2;
+			buffer.resize(size);
+			mask = size - 1;
+		}
+
+		bool Push(const T &item)
+		{
+			uint64_t t = tail.load(std::memory_order_relaxed);
+			if (t - head.load(std::memory_order_acquire) == buffer.size())
+				return false;
+			buffer[t & mask] = item;
+			tail.store(t + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Pop(T &item)
+		{
+			uint64_t h = head.load(std::memory_order_relaxed);
+			if (h == tail.load(std::memory_order_acquire))
+				return false;
+			item = buffer[h & mask];
+			head.store(h + 1, std::memory_order_release);
+			return true;
+		}
+
+		bool Empty()
+		{
+			return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+		}
+
+		private:
+		std::vector<T> buffer;
+		uint64_t mask;
+
+		// Keep the two ends on separate cache lines so the threads don't fight over them.
+		alignas(64) std::atomic<uint64_t> head; // Next slot to pop. Written by the consumer.
+		alignas(64) std::atomic<uint64_t> tail; // Next slot to push. Written by the producer.
+	};
+}
+
+#endif
@@ -0,0 +1,423 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#include "SSD_Device.h"
+#include "PCI_SSD_System.h"
+#include "FlashBackend.h"
+#include "StubBackend.h"
+#include "Checkpoint.h"
+#ifndef NO_HYBRIDSIM
+#include "HybridSimBackend.h"
+#endif
+
+namespace PCISSD
+{
+	SSD_Device::SSD_Device(PCI_SSD_System *parent, uint id)
+	{
+		assert(parent != NULL);
+
+		this->parent = parent;
+		this->id = id;
+
+		const Config &config = parent->config;
+
+		// Set up the backend.
+		// Backend ids are unique across systems as long as the system ids are at least NUM_DEVICES apart.
+		uint backend_id = parent->systemID * parent->num_devices + id;
+		if (config.backend_type == BACKEND_FLASH)
+		{
+			backend = new FlashBackend(backend_id, config.flash_channels, config.flash_dies_per_channel, config.flash_page_size,
+					config.flash_pages_per_block, config.flash_read_delay, config.flash_program_delay, config.flash_erase_delay,
+					config.flash_command_delay, config.flash_channel_rate);
+		}
+		else if (config.backend_type == BACKEND_STUB)
+		{
+			backend = new StubBackend(backend_id, config.stub_delay);
+		}
+		else
+		{
+#ifdef NO_HYBRIDSIM
+			cerr << "ERROR: PCI_SSD was built without HybridSim. Use BACKEND_FLASH or BACKEND_STUB instead.\n";
+			abort();
+#else
+			backend = new HybridSimBackend(backend_id, config.hybridsim_ini);
+#endif
+		}
+
+		// Register callbacks to the backend.
+		typedef Callback <SSD_Device, void, uint, uint64_t, uint64_t> backend_callback_t;
+		BackendCompleteCB *read_cb = new backend_callback_t(this, &SSD_Device::Backend_Read_Callback);
+		BackendCompleteCB *write_cb = new backend_callback_t(this, &SSD_Device::Backend_Write_Callback);
+		backend->RegisterCallbacks(read_cb, write_cb);
+
+		// Set up the backend's clock domain.
+		// The flash and stub models count in ns, so they run on the internal 1 GHz clock.
+		ClockDomain::ClockUpdateCB *backend_cd_callback = new ClockDomain::Callback<SSD_Device, void>(this, &SSD_Device::backend_update_internal);
+		if (config.backend_type != BACKEND_HYBRIDSIM)
+			backend_clockdomain = new ClockDomain::ClockDomainCrosser(1, 1, backend_cd_callback);
+		else
+			backend_clockdomain = new ClockDomain::ClockDomainCrosser(config.hybridsim_clock_1, config.hybridsim_clock_2, backend_cd_callback);
+
+		// Set up the controller cache.
+		cache = NULL;
+		if (config.enable_cache)
+		{
+			cache = new ControllerCache(parent, this, config.cache_size, config.cache_ways, config.cache_write_back,
+					config.cache_hit_delay, config.cache_sector_delay, config.cache_max_destage, config.cache_destage_buffer,
+					config.cache_dirty_threshold);
+		}
+
+		// Set up the stream prefetcher.
+		prefetcher = NULL;
+		if (config.enable_prefetch)
+		{
+			prefetcher = new StreamPrefetcher(parent, this, config.prefetch_streams, config.prefetch_threshold, config.prefetch_degree,
+					config.prefetch_max_stride, config.prefetch_max_outstanding, config.prefetch_buffer_size);
+		}
+	}
+
+	SSD_Device::~SSD_Device()
+	{
+		delete backend_clockdomain;
+		delete cache;
+		delete prefetcher;
+		delete backend;
+	}
+
+	void SSD_Device::update()
+	{
+		// Do processing for the cache destage engine.
+		if (cache != NULL)
+			cache->update();
+
+		// Call update for the backend.
+		// This uses a clock domain crosser due to the different clock rates.
+		// The callback is backend_update_internal.
+		backend_clockdomain->update();
+	}
+
+	void SSD_Device::printLogfile(ostream &out)
+	{
+		backend->printLogfile(out);
+
+		if (cache != NULL)
+			cache->Print_Stats(out);
+
+		if (prefetcher != NULL)
+			prefetcher->Print_Stats(out);
+	}
+
+	void SSD_Device::Save(ostream &out)
+	{
+		save_value(out, backend_clockdomain->counter1);
+		save_value(out, backend_clockdomain->counter2);
+
+		save_value(out, backend_transactions);
+		save_value(out, backend_accesses);
+		save_value(out, backend_base_address);
+		save_value(out, backend_sectors);
+
+		if (cache != NULL)
+			cache->Save(out);
+		if (prefetcher != NULL)
+			prefetcher->Save(out);
+
+		backend->Save(out);
+	}
+
+	void SSD_Device::Restore(istream &in)
+	{
+		restore_value(in, backend_clockdomain->counter1);
+		restore_value(in, backend_clockdomain->counter2);
+
+		restore_value(in, backend_transactions);
+		restore_value(in, backend_accesses);
+		restore_value(in, backend_base_address);
+		restore_value(in, backend_sectors);
+
+		if (cache != NULL)
+			cache->Restore(in);
+		if (prefetcher != NULL)
+			prefetcher->Restore(in);
+
+		backend->Restore(in);
+	}
+
+	void SSD_Device::Access(Transaction t)
+	{
+		// Writes make any prefetched copy of their sectors stale. This is done on every retry too, since
+		// a prefetch may have been issued while the write was waiting.
+		if ((prefetcher != NULL) && (t.isWrite))
+		{
+			prefetcher->Invalidate(t);
+		}
+
+		if (cache != NULL)
+			cache->Access(t);
+		else
+			Backend_Access(t);
+	}
+
+	// Returns false if the transaction has to retry, in which case it comes back through Access().
+	bool SSD_Device::Backend_Access(Transaction t)
+	{
+		// Reads that missed the cache may still find their sectors in the prefetch buffer.
+		if ((prefetcher != NULL) && (!t.isWrite) && (prefetcher->Hit(t)))
+		{
+			TransactionEvent e (PREFETCH_HIT_EVENT, t, parent->currentClockCycle + parent->config.cache_hit_delay + parent->config.cache_sector_delay * t.num_sectors);
+			parent->Add_Event(e);
+			return true;
+		}
+
+		// Destages and prefetches run in the background, so a host transaction can find one of its sectors still
+		// in the backend. Only one access per address can be outstanding in the backend, so wait for it to finish.
+		// For a prefetch this means the read is served from the prefetch buffer once it lands.
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			if (Backend_Sector_Busy(t.addr + i * SECTOR_SIZE))
+			{
+				if (DEBUG)
+				{
+					(parent->debug_file) << parent->currentClockCycle << " : Sector busy in backend, retrying transaction (" << t.isWrite << ", " << t.addr << ")\n";
+					parent->debug_file.flush();
+				}
+
+				parent->Retry_Event(TransactionEvent(CONTROLLER_RETRY_EVENT, t, parent->currentClockCycle));
+				return false;
+			}
+		}
+
+		handle_backend_add_transaction(t);
+		return true;
+	}
+
+	// Functional versions of Access() and Backend_Access(). They update the cache, prefetcher and backend
+	// state the same way, but take no time and return nothing to the host.
+	void SSD_Device::Functional_Access(Transaction t)
+	{
+		if (prefetcher != NULL)
+		{
+			if (t.isWrite)
+				prefetcher->Invalidate(t);
+			else
+				prefetcher->Train(t, true);
+		}
+
+		if (cache != NULL)
+			cache->Functional_Access(t);
+		else
+			Functional_Backend_Access(t);
+	}
+
+	// Returns true if the prefetch buffer served the transaction.
+	bool SSD_Device::Functional_Backend_Access(Transaction t)
+	{
+		if ((prefetcher != NULL) && (!t.isWrite) && (prefetcher->Hit(t)))
+			return true;
+
+		backend->Functional_Access(t.isWrite, t.addr, (uint64_t)t.num_sectors * SECTOR_SIZE);
+		return false;
+	}
+
+	void SSD_Device::Backend_Transaction_Done(Transaction t)
+	{
+		if (t.origin == DESTAGE_TRANSACTION)
+		{
+			// Destages are internal to the controller and have nowhere to return to.
+			cache->Destage_Done(t);
+			return;
+		}
+		else if (t.origin == PREFETCH_TRANSACTION)
+		{
+			prefetcher->Prefetch_Done(t);
+			return;
+		}
+
+		if (cache != NULL)
+			cache->Backend_Done(t);
+
+		// Send the transaction back up through this device's link.
+		parent->Device_Transaction_Done(t);
+	}
+
+	bool SSD_Device::Backend_Sector_Busy(uint64_t sector)
+	{
+		return backend_sectors.count(sector) != 0;
+	}
+
+	void SSD_Device::handle_backend_add_transaction(Transaction t)
+	{
+		// This code splits the transaction into requests no larger than the backend accepts.
+		// HybridSim only takes 64 byte accesses, while other backends can take a page or the whole transaction.
+		// The base address for all requests is the aligned sector address.
+		uint64_t base_address = t.addr;
+		uint64_t total_bytes = (uint64_t)t.num_sectors * SECTOR_SIZE;
+		uint64_t request_size = backend->Max_Request_Size();
+
+		// Assert that there is not an outstanding access to this sector.
+		assert(backend_transactions.count(base_address) == 0);
+		assert(backend_accesses.count(base_address) == 0);
+
+		// Create entries for this sector access.
+		backend_transactions[base_address] = t; // Save the transaction object for use by the callback.
+		backend_accesses[base_address] = set<uint64_t>(); // Empty set for the outstanding backend accesses.
+
+		// I like assertions. They prevent migraines.
+		assert(backend_transactions.count(base_address) == 1);
+		assert(backend_accesses.count(base_address) == 1);
+
+		// Mark every sector as busy in the backend.
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			uint64_t cur_sector = base_address + i * SECTOR_SIZE;
+			assert(backend_sectors.count(cur_sector) == 0);
+			backend_sectors.insert(cur_sector);
+		}
+
+
+		// Split at multiples of request_size so each request stays within one backend unit (e.g. a flash page).
+		uint64_t num_requests = 0;
+		uint64_t offset = 0;
+		while (offset < total_bytes)
+		{
+			uint64_t cur_address = base_address + offset;
+			uint64_t cur_size = total_bytes - offset;
+			if (request_size != 0)
+				cur_size = min(cur_size, request_size - (cur_address % request_size));
+
+			// Save this access in the access list for this base address.
+			backend_accesses[base_address].insert(cur_address);
+
+			// Save the mapping from this access to the current base address.
+			// This is necessary because of the variable sized transactions do not allow for an easy
+			// way to compute the base address from the access address.
+			assert(backend_base_address.count(cur_address) == 0);
+			backend_base_address[cur_address] = base_address;
+			assert(backend_base_address.count(cur_address) == 1);
+
+			// Send this request to the backend.
+			bool success = backend->addTransaction(t.isWrite, cur_address, cur_size);
+			assert(success); // Backends should never fail since they just return true. :)
+
+			offset += cur_size;
+			num_requests++;
+		}
+
+
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Added " << num_requests << " to backend for base address " << base_address << "\n";
+			parent->debug_file.flush();
+		}
+	}
+
+	void SSD_Device::handle_backend_callback(bool isWrite, uint64_t addr)
+	{
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Received callback from backend (" << isWrite << ", " << addr << ")\n";
+			parent->debug_file.flush();
+		}
+
+		// Compute the base address.
+		assert(backend_base_address.count(addr) == 1);
+		uint64_t base_address = backend_base_address[addr];
+		backend_base_address.erase(addr);
+		assert(backend_base_address.count(addr) == 0);
+
+		// Check that this address is in the pending state for the backend.
+		assert(backend_transactions.count(base_address) == 1);
+		assert(backend_accesses.count(base_address) == 1);
+
+		// Get the transaction
+		Transaction old_t = backend_transactions[base_address];
+		assert(isWrite == old_t.isWrite);
+		assert(base_address == old_t.addr);
+
+		// Remove current address from the access set for the base address.
+		assert(backend_accesses[base_address].count(addr) == 1);
+		backend_accesses[base_address].erase(addr);
+		assert(backend_accesses[base_address].count(addr) == 0);
+
+		
+		// If the whole sector transaction is done, then send it back up.
+		if (backend_accesses[base_address].empty())
+		{
+			if (DEBUG)
+			{
+				(parent->debug_file) << parent->currentClockCycle << " : Finished backend transactions for base address " << base_address << "\n";
+				parent->debug_file.flush();
+			}
+
+			// Create a Transaction for the return path.
+			// Not reusing old_t since it should be deleted by the pending state cleanup.
+			// The only thing I need from old_t is the orig_addr (which is the address before SECTOR_ALIGN()).
+			//Transaction t(isWrite, base_address, old_t.orig_addr, old_t.num_sectors, old_t.dma_sg_base, old_t.dma_sg_len);
+			//Transaction t(isWrite, base_address, old_t.orig_addr, old_t.num_sectors);
+			Transaction t = old_t; // Make a deep copy.
+
+			// Remove the pending state.
+			backend_transactions.erase(base_address);
+			backend_accesses.erase(base_address);
+
+			// Check that the pending state is cleared.
+			assert(backend_transactions.count(base_address) == 0);
+			assert(backend_accesses.count(base_address) == 0);
+
+			// Release the sectors.
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+			{
+				uint64_t cur_sector = base_address + i * SECTOR_SIZE;
+				assert(backend_sectors.count(cur_sector) == 1);
+				backend_sectors.erase(cur_sector);
+			}
+
+			Backend_Transaction_Done(t);
+		}
+	}
+
+	void SSD_Device::Backend_Read_Callback(uint id, uint64_t addr, uint64_t cycle)
+	{
+		handle_backend_callback(false, addr);
+	}
+
+	void SSD_Device::Backend_Write_Callback(uint id, uint64_t addr, uint64_t cycle)
+	{
+		handle_backend_callback(true, addr);
+	}
+
+	void SSD_Device::backend_update_internal()
+	{
+		// Call the backend at the appropriate clock rate.
+		// Ratio of call is HYBRIDSIM_CLOCK_1 : HYBRIDSIM_CLOCK_2 for HybridSim and 1 : 1 for the flash model.
+		ProfileScope scope(parent->profiler, PROFILE_BACKEND);
+		backend->update();
+	}
+}
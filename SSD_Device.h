@@ -0,0 +1,97 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_DEVICE_H
+#define PCI_SSD_DEVICE_H
+
+#include "Backend.h"
+#include "ControllerCache.h"
+#include "StreamPrefetcher.h"
+#include "Transaction.h"
+#include "common.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	class PCI_SSD_System;
+
+	// One SSD behind Layer 2: the controller (cache and prefetcher) and its backend.
+	// Every transaction that reaches a device has already been striped, so addresses here are
+	// device-local. Completed host transactions are handed back with parent->Device_Transaction_Done().
+	class SSD_Device
+	{
+		public:
+		SSD_Device(PCI_SSD_System *parent, uint id);
+		~SSD_Device();
+
+		void update();
+		void printLogfile(ostream &out);
+
+		// Checkpoint functions
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// SSD controller functions
+		void Access(Transaction t);
+		void Functional_Access(Transaction t);
+		bool Functional_Backend_Access(Transaction t);
+		bool Backend_Access(Transaction t);
+		void Backend_Transaction_Done(Transaction t);
+		bool Backend_Sector_Busy(uint64_t sector);
+
+		void handle_backend_add_transaction(Transaction t);
+		void handle_backend_callback(bool isWrite, uint64_t addr);
+
+		void Backend_Read_Callback(uint id, uint64_t addr, uint64_t cycle);
+		void Backend_Write_Callback(uint id, uint64_t addr, uint64_t cycle);
+		void backend_update_internal();
+
+
+		// Internal state
+		PCI_SSD_System *parent;
+		uint id;
+
+		Backend *backend;
+		ClockDomain::ClockDomainCrosser *backend_clockdomain;
+
+		// State to save while the backend is doing its thing.
+		unordered_map<uint64_t, Transaction> backend_transactions; // Outstanding sector transactions.
+		unordered_map<uint64_t, set<uint64_t>> backend_accesses; // Outstanding acceses to the backend for each sector.
+		unordered_map<uint64_t, uint64_t> backend_base_address; // Base address for an outstanding access.
+		unordered_set<uint64_t> backend_sectors; // Every sector with an outstanding access to the backend.
+
+		ControllerCache *cache;
+
+		StreamPrefetcher *prefetcher;
+	};
+}
+
+#endif
@@ -0,0 +1,154 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Scheduler.h"
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+	Scheduler::Scheduler(uint64_t type, vector<uint64_t> weights, vector<uint64_t> deadlines, uint64_t write_starvation)
+	{
+		assert(type <= SCHEDULER_DEADLINE);
+		assert(weights.size() == NUM_QOS_CLASSES);
+		assert(deadlines.size() == NUM_QOS_CLASSES);
+
+		this->type = type;
+		this->weights = weights;
+		this->deadlines = deadlines;
+		this->write_starvation = write_starvation;
+
+		finish_time.resize(NUM_QOS_CLASSES, 0);
+		virtual_time = 0;
+		writes_passed = 0;
+	}
+
+	list<Transaction>::iterator Scheduler::Pick(list<Transaction> &queue)
+	{
+		assert(!queue.empty());
+
+		if (type == SCHEDULER_FIFO)
+			return queue.begin();
+
+		list<Transaction>::iterator best = queue.begin();
+		if (type == SCHEDULER_PRIORITY)
+		{
+			// Oldest transaction of the most important class.
+			for (list<Transaction>::iterator it = queue.begin(); it != queue.end(); it++)
+				if (it->qos_class < best->qos_class)
+					best = it;
+		}
+		else if (type == SCHEDULER_WFQ)
+		{
+			// Start-time fair queuing. A class that has been idle starts again at the current virtual time,
+			// so it cannot save up a share of the link while it has nothing queued.
+			uint64_t best_start = 0;
+			for (list<Transaction>::iterator it = queue.begin(); it != queue.end(); it++)
+			{
+				uint64_t start = max(finish_time[it->qos_class], virtual_time);
+				if ((it == queue.begin()) || (start < best_start))
+				{
+					best = it;
+					best_start = start;
+				}
+			}
+		}
+		else if (type == SCHEDULER_READ_FIRST)
+		{
+			list<Transaction>::iterator first_read = queue.end();
+			list<Transaction>::iterator first_write = queue.end();
+			for (list<Transaction>::iterator it = queue.begin(); it != queue.end(); it++)
+			{
+				if ((it->isWrite) && (first_write == queue.end()))
+					first_write = it;
+				else if ((!it->isWrite) && (first_read == queue.end()))
+					first_read = it;
+			}
+
+			if ((first_read == queue.end()) || ((first_write != queue.end()) && (writes_passed >= write_starvation)))
+				best = first_write;
+			else
+				best = first_read;
+		}
+		else if (type == SCHEDULER_DEADLINE)
+		{
+			// Earliest deadline first, oldest first on a tie.
+			for (list<Transaction>::iterator it = queue.begin(); it != queue.end(); it++)
+				if (it->issue_time + deadlines[it->qos_class] < best->issue_time + deadlines[best->qos_class])
+					best = it;
+		}
+
+		return best;
+	}
+
+	void Scheduler::Served(const Transaction &t, list<Transaction> &queue)
+	{
+		assert(t.qos_class < NUM_QOS_CLASSES);
+
+		if (type == SCHEDULER_WFQ)
+		{
+			uint64_t start = max(finish_time[t.qos_class], virtual_time);
+			finish_time[t.qos_class] = start + ((uint64_t)t.num_sectors * SECTOR_SIZE) / weights[t.qos_class];
+			virtual_time = start;
+		}
+		else if (type == SCHEDULER_READ_FIRST)
+		{
+			if (t.isWrite)
+			{
+				writes_passed = 0;
+			}
+			else
+			{
+				for (list<Transaction>::iterator it = queue.begin(); it != queue.end(); it++)
+				{
+					if (it->isWrite)
+					{
+						writes_passed++;
+						break;
+					}
+				}
+			}
+		}
+	}
+
+	void Scheduler::Save(ostream &out)
+	{
+		save_value(out, finish_time);
+		save_value(out, virtual_time);
+		save_value(out, writes_passed);
+	}
+
+	void Scheduler::Restore(istream &in)
+	{
+		restore_value(in, finish_time);
+		restore_value(in, virtual_time);
+		restore_value(in, writes_passed);
+	}
+}
@@ -0,0 +1,72 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_SCHEDULER_H
+#define PCI_SSD_SCHEDULER_H
+
+#include <vector>
+
+#include "common.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	// Picks the next transaction to go out of a link queue (LAYER_SCHEDULER in config.h).
+	// Each link has one for its send queue and one for its return queue.
+	class Scheduler
+	{
+		public:
+		Scheduler(uint64_t type, vector<uint64_t> weights, vector<uint64_t> deadlines, uint64_t write_starvation);
+
+		// Returns the transaction that should go next. The queue must not be empty.
+		list<Transaction>::iterator Pick(list<Transaction> &queue);
+
+		// Called once the picked transaction has been removed from the queue and started.
+		void Served(const Transaction &t, list<Transaction> &queue);
+
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+
+		// Parameters
+		uint64_t type;
+		vector<uint64_t> weights;
+		vector<uint64_t> deadlines; // In cycles.
+		uint64_t write_starvation;
+
+		// Internal state
+		vector<uint64_t> finish_time; // Virtual time each class's last transaction finishes at (WFQ).
+		uint64_t virtual_time; // Start tag of the last transaction served (WFQ).
+		uint64_t writes_passed; // Reads that went ahead of a waiting write since the last write (READ_FIRST).
+	};
+}
+
+#endif
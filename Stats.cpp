@@ -0,0 +1,313 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Stats.h"
+#include "Checkpoint.h"
+#include <algorithm>
+
+namespace PCISSD
+{
+	Stats::Stats(uint64_t window_length, uint64_t steady_windows, uint64_t steady_threshold, uint64_t confidence)
+	{
+		assert(window_length > 0);
+		assert(steady_windows > 1);
+
+		this->window_length = window_length;
+		this->steady_windows = steady_windows;
+		this->steady_threshold = steady_threshold;
+		this->confidence = confidence;
+
+		window_end = window_length;
+		window_requests = 0;
+		window_latency = 0;
+
+		steady = false;
+		converged = false;
+		steady_start = 0;
+		steady_requests = 0;
+		steady_latency = 0;
+
+		reads = 0;
+		writes = 0;
+		total_latency = 0;
+		class_requests.resize(NUM_QOS_CLASSES, 0);
+		class_latency.resize(NUM_QOS_CLASSES, 0);
+		class_histogram.resize(NUM_QOS_CLASSES, vector<uint64_t>(Histogram_Bucket(UINT64_MAX) + 1, 0));
+	}
+
+	void Stats::Complete(bool isWrite, uint qos_class, uint64_t latency)
+	{
+		assert(qos_class < NUM_QOS_CLASSES);
+
+		if (isWrite)
+			writes++;
+		else
+			reads++;
+		total_latency += latency;
+
+		class_requests[qos_class]++;
+		class_latency[qos_class] += latency;
+		class_histogram[qos_class][Histogram_Bucket(latency)]++;
+
+		window_requests++;
+		window_latency += latency;
+
+		if (steady)
+		{
+			steady_requests++;
+			steady_latency += latency;
+		}
+	}
+
+	void Stats::Update(uint64_t cycle)
+	{
+		if (cycle < window_end)
+			return;
+
+		Close_Window();
+		window_end += window_length;
+	}
+
+	bool Stats::Steady()
+	{
+		return steady;
+	}
+
+	bool Stats::Converged()
+	{
+		return converged;
+	}
+
+	void Stats::Print_Stats(ostream &out)
+	{
+		uint64_t requests = reads + writes;
+		double mean = requests ? (double)total_latency / (double)requests : 0.0;
+
+		out << "PCI_SSD requests: " << requests << " (reads: " << reads << ", writes: " << writes << "), mean latency: " << mean << " ns\n";
+
+		// Only break the latency down by class when more than one class was used.
+		if ((uint64_t)count(class_requests.begin(), class_requests.end(), 0) < NUM_QOS_CLASSES - 1)
+		{
+			for (uint c=0; c < NUM_QOS_CLASSES; c++)
+			{
+				if (class_requests[c] == 0)
+					continue;
+
+				out << "\tclass " << c << " requests: " << class_requests[c] << ", mean latency: " << (double)class_latency[c] / class_requests[c]
+						<< " ns, p50: " << Class_Percentile(c, 50) << " ns, p99: " << Class_Percentile(c, 99) << " ns, p99.9: " << Class_Percentile(c, 99.9) << " ns\n";
+			}
+		}
+
+		if (!steady)
+		{
+			out << "PCI_SSD steady state not reached (" << window_length << " ns windows)\n";
+			return;
+		}
+
+		double throughput, throughput_error, latency, latency_error;
+		Mean_Confidence(batch_throughput, throughput, throughput_error);
+		Mean_Confidence(batch_latency, latency, latency_error);
+
+		// Window throughput is in requests per window. Report it per second.
+		double scale = 1000000000.0 / window_length;
+
+		out << "PCI_SSD steady state from " << steady_start << " ns (" << batch_throughput.size() << " windows of " << window_length << " ns)\n";
+		out << "\trequests: " << steady_requests << ", mean latency: " << (steady_requests ? (double)steady_latency / steady_requests : 0.0) << " ns\n";
+		out << "\twindow mean latency: " << latency << " ns (95% confidence: +/- " << latency_error << ")\n";
+		out << "\tthroughput: " << throughput * scale << " requests/s (95% confidence: +/- " << throughput_error * scale << ")\n";
+	}
+
+	void Stats::Close_Window()
+	{
+		double throughput = (double)window_requests;
+		double latency = window_requests ? (double)window_latency / (double)window_requests : 0.0;
+		window_requests = 0;
+		window_latency = 0;
+
+		if (steady)
+		{
+			batch_throughput.push_back(throughput);
+			if (throughput > 0)
+				batch_latency.push_back(latency);
+
+			// Check the confidence intervals once there are as many batches as it took to detect steady state.
+			if ((confidence != 0) && (batch_latency.size() >= steady_windows))
+			{
+				double throughput_error, latency_error;
+				Mean_Confidence(batch_throughput, throughput, throughput_error);
+				Mean_Confidence(batch_latency, latency, latency_error);
+				converged = (throughput_error * 100 <= throughput * confidence) && (latency_error * 100 <= latency * confidence);
+			}
+			return;
+		}
+
+		recent_throughput.push_back(throughput);
+		recent_latency.push_back(latency);
+		if (recent_throughput.size() > steady_windows)
+		{
+			recent_throughput.pop_front();
+			recent_latency.pop_front();
+		}
+
+		if (recent_throughput.size() < steady_windows)
+			return;
+
+		if ((Variation(recent_throughput) * 100 < steady_threshold) && (Variation(recent_latency) * 100 < steady_threshold))
+		{
+			steady = true;
+			steady_start = window_end;
+		}
+	}
+
+	// Coefficient of variation. Samples with a mean of 0 never count as steady.
+	double Stats::Variation(list<double> &samples)
+	{
+		double mean = 0.0;
+		for (list<double>::iterator it = samples.begin(); it != samples.end(); it++)
+			mean += *it;
+		mean /= samples.size();
+
+		if (mean <= 0.0)
+			return INFINITY;
+
+		double variance = 0.0;
+		for (list<double>::iterator it = samples.begin(); it != samples.end(); it++)
+			variance += (*it - mean) * (*it - mean);
+		variance /= (samples.size() - 1);
+
+		return sqrt(variance) / mean;
+	}
+
+	// Normal approximation, treating each window as one batch mean.
+	void Stats::Mean_Confidence(vector<double> &samples, double &mean, double &half_width)
+	{
+		mean = 0.0;
+		half_width = 0.0;
+		if (samples.empty())
+			return;
+
+		for (uint64_t i=0; i < samples.size(); i++)
+			mean += samples[i];
+		mean /= samples.size();
+
+		if (samples.size() < 2)
+			return;
+
+		double variance = 0.0;
+		for (uint64_t i=0; i < samples.size(); i++)
+			variance += (samples[i] - mean) * (samples[i] - mean);
+		variance /= (samples.size() - 1);
+
+		half_width = 1.96 * sqrt(variance / samples.size());
+	}
+
+	// Upper limit of the bucket holding the request at rank p percent.
+	uint64_t Stats::Class_Percentile(uint qos_class, double p)
+	{
+		vector<uint64_t> &histogram = class_histogram[qos_class];
+		uint64_t rank = (uint64_t)ceil(p / 100.0 * class_requests[qos_class]);
+		rank = max(rank, (uint64_t)1);
+
+		uint64_t seen = 0;
+		for (uint64_t b=0; b < histogram.size(); b++)
+		{
+			seen += histogram[b];
+			if (seen >= rank)
+				return Bucket_Limit(b);
+		}
+
+		return 0;
+	}
+
+	// Latencies below 16 get a bucket each. Above that, each power of two is split into 16 buckets.
+	uint64_t Stats::Histogram_Bucket(uint64_t latency)
+	{
+		if (latency < 16)
+			return latency;
+
+		uint64_t exponent = 63 - __builtin_clzll(latency);
+		return 16 * (exponent - 3) + ((latency >> (exponent - 4)) - 16);
+	}
+
+	uint64_t Stats::Bucket_Limit(uint64_t bucket)
+	{
+		if (bucket < 16)
+			return bucket;
+
+		uint64_t exponent = bucket / 16 + 3;
+		uint64_t lower = (16 + bucket % 16) << (exponent - 4);
+		return lower + ((uint64_t)1 << (exponent - 4)) - 1;
+	}
+
+	void Stats::Save(ostream &out)
+	{
+		save_value(out, window_end);
+		save_value(out, window_requests);
+		save_value(out, window_latency);
+		save_value(out, recent_throughput);
+		save_value(out, recent_latency);
+		save_value(out, steady);
+		save_value(out, converged);
+		save_value(out, steady_start);
+		save_value(out, steady_requests);
+		save_value(out, steady_latency);
+		save_value(out, batch_throughput);
+		save_value(out, batch_latency);
+		save_value(out, reads);
+		save_value(out, writes);
+		save_value(out, total_latency);
+		save_value(out, class_requests);
+		save_value(out, class_latency);
+		save_value(out, class_histogram);
+	}
+
+	void Stats::Restore(istream &in)
+	{
+		restore_value(in, window_end);
+		restore_value(in, window_requests);
+		restore_value(in, window_latency);
+		restore_value(in, recent_throughput);
+		restore_value(in, recent_latency);
+		restore_value(in, steady);
+		restore_value(in, converged);
+		restore_value(in, steady_start);
+		restore_value(in, steady_requests);
+		restore_value(in, steady_latency);
+		restore_value(in, batch_throughput);
+		restore_value(in, batch_latency);
+		restore_value(in, reads);
+		restore_value(in, writes);
+		restore_value(in, total_latency);
+		restore_value(in, class_requests);
+		restore_value(in, class_latency);
+		restore_value(in, class_histogram);
+	}
+}
@@ -0,0 +1,105 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_STATS_H
+#define PCI_SSD_STATS_H
+
+#include <vector>
+
+#include "common.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	// Host request statistics with automatic steady state detection.
+	// Completions are grouped into windows of window_length cycles. The run is in steady state once the
+	// throughput and the mean latency of the last steady_windows windows each have a coefficient of variation
+	// below steady_threshold percent. The steady state counters start at that point, so warm-up only shows
+	// up in the totals. The steady state windows are then used as batch means for 95% confidence intervals.
+	// With a nonzero confidence, the run has converged once both intervals are within that percentage of their means.
+	// Latency is also kept per QoS class in log-linear histograms (16 buckets per power of two), so the class
+	// percentiles are within about 6% of the exact values.
+	class Stats
+	{
+		public:
+		Stats(uint64_t window_length, uint64_t steady_windows, uint64_t steady_threshold, uint64_t confidence);
+
+		void Complete(bool isWrite, uint qos_class, uint64_t latency);
+		void Update(uint64_t cycle);
+		bool Steady();
+		bool Converged();
+		void Print_Stats(ostream &out);
+
+		// Checkpoint functions
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Internal functions
+		void Close_Window();
+		double Variation(list<double> &samples);
+		void Mean_Confidence(vector<double> &samples, double &mean, double &half_width);
+		uint64_t Class_Percentile(uint qos_class, double p);
+		static uint64_t Histogram_Bucket(uint64_t latency);
+		static uint64_t Bucket_Limit(uint64_t bucket); // Largest latency that falls in the bucket.
+
+
+		// Parameters
+		uint64_t window_length;
+		uint64_t steady_windows;
+		uint64_t steady_threshold;
+		uint64_t confidence;
+
+		// Internal state
+		uint64_t window_end; // Cycle the current window ends on.
+		uint64_t window_requests;
+		uint64_t window_latency;
+		list<double> recent_throughput; // Requests and mean latency of the last steady_windows windows.
+		list<double> recent_latency;
+
+		bool steady;
+		bool converged;
+		uint64_t steady_start; // Cycle steady state was detected on.
+		uint64_t steady_requests;
+		uint64_t steady_latency;
+		vector<double> batch_throughput; // Requests and mean latency of every window since steady state began.
+		vector<double> batch_latency;
+
+		// Totals for the whole run, including warm-up.
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t total_latency;
+		vector<uint64_t> class_requests;
+		vector<uint64_t> class_latency;
+		vector<vector<uint64_t> > class_histogram;
+	};
+}
+
+#endif
@@ -0,0 +1,374 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#include "StreamPrefetcher.h"
+#include "PCI_SSD_System.h"
+#include "SSD_Device.h"
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+	static void save_value(ostream &out, const PrefetchStream &s)
+	{
+		save_value(out, s.valid);
+		save_value(out, s.last_addr);
+		save_value(out, s.stride);
+		save_value(out, s.confidence);
+		save_value(out, s.prefetched_until);
+		save_value(out, s.last_used);
+	}
+
+	static void restore_value(istream &in, PrefetchStream &s)
+	{
+		restore_value(in, s.valid);
+		restore_value(in, s.last_addr);
+		restore_value(in, s.stride);
+		restore_value(in, s.confidence);
+		restore_value(in, s.prefetched_until);
+		restore_value(in, s.last_used);
+	}
+
+
+	StreamPrefetcher::StreamPrefetcher(PCI_SSD_System *parent, SSD_Device *device, uint64_t num_streams, uint64_t threshold, uint64_t degree, uint64_t max_stride,
+			uint64_t max_outstanding, uint64_t buffer_size)
+	{
+		assert(parent != NULL);
+		assert(device != NULL);
+		assert(num_streams > 0);
+		assert(threshold > 0);
+
+		this->parent = parent;
+		this->device = device;
+		this->threshold = threshold;
+		this->degree = degree;
+		this->max_stride = max_stride;
+		this->max_outstanding = max_outstanding;
+		this->buffer_size = buffer_size;
+
+		streams.resize(num_streams);
+		access_count = 0;
+		outstanding = 0;
+
+		demand_sectors = 0;
+		prefetched_sectors = 0;
+		useful_sectors = 0;
+		unused_sectors = 0;
+		streams_detected = 0;
+	}
+
+	// In functional mode the prefetches are not sent to the backend. Their sectors go straight into the buffer.
+	void StreamPrefetcher::Train(Transaction t, bool functional)
+	{
+		assert(!t.isWrite);
+
+		access_count++;
+		demand_sectors += t.num_sectors;
+
+		// Look for a stream that predicted this address.
+		for (uint64_t i=0; i < streams.size(); i++)
+		{
+			PrefetchStream &s = streams[i];
+			if (s.valid && (s.stride != 0) && (t.addr == s.last_addr + s.stride))
+			{
+				s.last_addr = t.addr;
+				s.last_used = access_count;
+				s.confidence++;
+
+				if (s.confidence == threshold)
+					streams_detected++;
+
+				if (s.confidence >= threshold)
+					Issue_Prefetches(s, t, functional);
+				return;
+			}
+		}
+
+		// Otherwise, look for a stream close enough to learn a new stride from.
+		for (uint64_t i=0; i < streams.size(); i++)
+		{
+			PrefetchStream &s = streams[i];
+			if (!s.valid)
+				continue;
+
+			int64_t stride = (int64_t)(t.addr - s.last_addr);
+			uint64_t distance = (stride < 0) ? (uint64_t)(-stride) : (uint64_t)stride;
+			if ((distance != 0) && (distance <= max_stride))
+			{
+				s.last_addr = t.addr;
+				s.stride = stride;
+				s.confidence = 1;
+				s.prefetched_until = t.addr;
+				s.last_used = access_count;
+				return;
+			}
+			else if (distance == 0)
+			{
+				// Repeated access to the same address. Nothing to learn.
+				s.last_used = access_count;
+				return;
+			}
+		}
+
+		// Start a new stream in place of the least recently used one.
+		uint64_t victim = 0;
+		for (uint64_t i=0; i < streams.size(); i++)
+		{
+			if (!streams[i].valid)
+			{
+				victim = i;
+				break;
+			}
+			if (streams[i].last_used < streams[victim].last_used)
+				victim = i;
+		}
+
+		PrefetchStream &s = streams[victim];
+		s.valid = true;
+		s.last_addr = t.addr;
+		s.stride = 0;
+		s.confidence = 0;
+		s.prefetched_until = t.addr;
+		s.last_used = access_count;
+	}
+
+	bool StreamPrefetcher::Hit(Transaction t)
+	{
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			if (buffer.count(t.addr + i * SECTOR_SIZE) == 0)
+				return false;
+		}
+
+		// The data moves to the host, so the sectors leave the buffer.
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+			buffer.erase(t.addr + i * SECTOR_SIZE);
+
+		useful_sectors += t.num_sectors;
+
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Prefetch buffer hit for transaction: (" << t.isWrite << ", " << t.addr << ")\n";
+			parent->debug_file.flush();
+		}
+
+		return true;
+	}
+
+	void StreamPrefetcher::Invalidate(Transaction t)
+	{
+		assert(t.isWrite);
+
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			uint64_t cur_sector = t.addr + i * SECTOR_SIZE;
+
+			if (buffer.count(cur_sector) != 0)
+			{
+				buffer.erase(cur_sector);
+				unused_sectors++;
+			}
+
+			// A prefetch in flight now holds old data. Drop it when it comes back.
+			if (inflight.count(cur_sector) != 0)
+				stale.insert(cur_sector);
+		}
+	}
+
+	void StreamPrefetcher::Prefetch_Done(Transaction t)
+	{
+		assert(t.origin == PREFETCH_TRANSACTION);
+		assert(outstanding > 0);
+		outstanding--;
+
+		for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+		{
+			uint64_t cur_sector = t.addr + i * SECTOR_SIZE;
+
+			assert(inflight.count(cur_sector) == 1);
+			inflight.erase(cur_sector);
+
+			if (stale.count(cur_sector) != 0)
+			{
+				stale.erase(cur_sector);
+				unused_sectors++;
+				continue;
+			}
+
+			Buffer_Sector(cur_sector);
+		}
+
+		if (DEBUG)
+		{
+			(parent->debug_file) << parent->currentClockCycle << " : Finished prefetch for " << t.addr << "\n";
+			parent->debug_file.flush();
+		}
+	}
+
+	void StreamPrefetcher::Print_Stats(ostream &out)
+	{
+		double accuracy = prefetched_sectors ? (double)useful_sectors / (double)prefetched_sectors : 0.0;
+		double coverage = demand_sectors ? (double)useful_sectors / (double)demand_sectors : 0.0;
+
+		out << "PCI_SSD stream prefetcher (" << streams.size() << " streams, degree " << degree << ")\n";
+		out << "\tstreams detected: " << streams_detected << "\n";
+		out << "\tdemand read sectors: " << demand_sectors << "\n";
+		out << "\tprefetched sectors: " << prefetched_sectors << " (useful: " << useful_sectors 
+				<< ", unused: " << unused_sectors << ")\n";
+		out << "\taccuracy: " << accuracy << "\n";
+		out << "\tcoverage: " << coverage << "\n";
+	}
+
+	void StreamPrefetcher::Issue_Prefetches(PrefetchStream &s, Transaction t, bool functional)
+	{
+		for (uint64_t k=1; k <= degree; k++)
+		{
+			if (outstanding >= max_outstanding)
+				return;
+
+			// Stop if the stream runs off the bottom of the address space.
+			if ((s.stride < 0) && ((uint64_t)(-s.stride) * k > t.addr))
+				return;
+
+			uint64_t addr = t.addr + s.stride * (int64_t)k;
+
+			// Skip what this stream has already prefetched.
+			if ((s.stride > 0) && (addr <= s.prefetched_until))
+				continue;
+			if ((s.stride < 0) && (addr >= s.prefetched_until))
+				continue;
+
+			s.prefetched_until = addr;
+
+			if (!Can_Prefetch(addr, t.num_sectors))
+				continue;
+
+			if (functional)
+			{
+				prefetched_sectors += t.num_sectors;
+				for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+					Buffer_Sector(addr + i * SECTOR_SIZE);
+				continue;
+			}
+
+			if (DEBUG)
+			{
+				(parent->debug_file) << parent->currentClockCycle << " : Issuing prefetch for " << addr 
+						<< " (" << t.num_sectors << " sectors)\n";
+				parent->debug_file.flush();
+			}
+
+			for (uint64_t i=0; i < (uint64_t)t.num_sectors; i++)
+				inflight.insert(addr + i * SECTOR_SIZE);
+
+			outstanding++;
+			prefetched_sectors += t.num_sectors;
+
+			list<uint64_t> empty;
+			Transaction p(false, addr, addr, t.num_sectors, empty, empty, PREFETCH_TRANSACTION);
+			p.device = device->id;
+			device->handle_backend_add_transaction(p);
+		}
+	}
+
+	void StreamPrefetcher::Buffer_Sector(uint64_t sector)
+	{
+		// Make room by dropping the oldest prefetched sectors.
+		while (buffer.size() >= buffer_size)
+		{
+			assert(!buffer_order.empty());
+			uint64_t old_sector = buffer_order.front();
+			buffer_order.pop_front();
+			if (buffer.count(old_sector) != 0)
+			{
+				buffer.erase(old_sector);
+				unused_sectors++;
+			}
+		}
+
+		buffer.insert(sector);
+		buffer_order.push_back(sector);
+
+		// Keep stale entries in buffer_order from piling up.
+		while ((!buffer_order.empty()) && (buffer.count(buffer_order.front()) == 0))
+			buffer_order.pop_front();
+	}
+
+	bool StreamPrefetcher::Can_Prefetch(uint64_t addr, int num_sectors)
+	{
+		for (uint64_t i=0; i < (uint64_t)num_sectors; i++)
+		{
+			uint64_t cur_sector = addr + i * SECTOR_SIZE;
+
+			// Nothing to gain if the sector is already here, and the backend only takes one access per address.
+			if ((buffer.count(cur_sector) != 0) || (inflight.count(cur_sector) != 0))
+				return false;
+			if (device->Backend_Sector_Busy(cur_sector))
+				return false;
+
+			// The cache is checked first on reads and may hold newer data than the backend.
+			if ((device->cache != NULL) && (device->cache->Present(cur_sector)))
+				return false;
+		}
+
+		return true;
+	}
+
+	void StreamPrefetcher::Save(ostream &out)
+	{
+		save_value(out, streams);
+		save_value(out, access_count);
+		save_value(out, buffer);
+		save_value(out, buffer_order);
+		save_value(out, inflight);
+		save_value(out, stale);
+		save_value(out, outstanding);
+		save_value(out, demand_sectors);
+		save_value(out, prefetched_sectors);
+		save_value(out, useful_sectors);
+		save_value(out, unused_sectors);
+		save_value(out, streams_detected);
+	}
+
+	void StreamPrefetcher::Restore(istream &in)
+	{
+		restore_value(in, streams);
+		restore_value(in, access_count);
+		restore_value(in, buffer);
+		restore_value(in, buffer_order);
+		restore_value(in, inflight);
+		restore_value(in, stale);
+		restore_value(in, outstanding);
+		restore_value(in, demand_sectors);
+		restore_value(in, prefetched_sectors);
+		restore_value(in, useful_sectors);
+		restore_value(in, unused_sectors);
+		restore_value(in, streams_detected);
+	}
+}
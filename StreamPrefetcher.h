@@ -0,0 +1,113 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+#ifndef PCI_SSD_STREAMPREFETCHER_H
+#define PCI_SSD_STREAMPREFETCHER_H
+
+#include "common.h"
+
+namespace PCISSD
+{
+	// Forward declare.
+	class PCI_SSD_System;
+	class SSD_Device;
+
+	class PrefetchStream
+	{
+		public:
+		bool valid;
+		uint64_t last_addr;
+		int64_t stride;
+		uint64_t confidence;
+		uint64_t prefetched_until; // Furthest address prefetched so far in the stride direction.
+		uint64_t last_used;
+
+		PrefetchStream()
+		{
+			valid = false;
+			last_addr = 0;
+			stride = 0;
+			confidence = 0;
+			prefetched_until = 0;
+			last_used = 0;
+		}
+	};
+
+	// Detects sequential and strided read streams at the SSD controller and reads ahead of them.
+	// Completed prefetches wait in a FIFO buffer until a demand read consumes them.
+	class StreamPrefetcher
+	{
+		public:
+		StreamPrefetcher(PCI_SSD_System *parent, SSD_Device *device, uint64_t num_streams, uint64_t threshold, uint64_t degree, uint64_t max_stride,
+				uint64_t max_outstanding, uint64_t buffer_size);
+
+		void Train(Transaction t, bool functional = false);
+		bool Hit(Transaction t);
+		void Invalidate(Transaction t);
+		void Prefetch_Done(Transaction t);
+		void Print_Stats(ostream &out);
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Internal functions
+		void Issue_Prefetches(PrefetchStream &s, Transaction t, bool functional);
+		void Buffer_Sector(uint64_t sector);
+		bool Can_Prefetch(uint64_t addr, int num_sectors);
+
+
+		// Parameters
+		PCI_SSD_System *parent;
+		SSD_Device *device;
+		uint64_t threshold;
+		uint64_t degree;
+		uint64_t max_stride;
+		uint64_t max_outstanding;
+		uint64_t buffer_size;
+
+		// Internal state
+		vector<PrefetchStream> streams;
+		uint64_t access_count; // Used for LRU replacement of streams.
+
+		unordered_set<uint64_t> buffer; // Prefetched sectors waiting for a demand read.
+		list<uint64_t> buffer_order; // FIFO order of buffer. Stale entries are skipped.
+		unordered_set<uint64_t> inflight; // Sectors with a prefetch in the backend.
+		unordered_set<uint64_t> stale; // Inflight sectors that were written after the prefetch was issued.
+		uint64_t outstanding;
+
+		// Stats
+		uint64_t demand_sectors;
+		uint64_t prefetched_sectors;
+		uint64_t useful_sectors;
+		uint64_t unused_sectors;
+		uint64_t streams_detected;
+	};
+}
+
+#endif
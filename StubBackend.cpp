@@ -0,0 +1,130 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "StubBackend.h"
+#include "Checkpoint.h"
+
+namespace PCISSD
+{
+	static void save_value(ostream &out, const StubRequest &r)
+	{
+		save_value(out, r.isWrite);
+		save_value(out, r.addr);
+		save_value(out, r.done_time);
+	}
+
+	static void restore_value(istream &in, StubRequest &r)
+	{
+		restore_value(in, r.isWrite);
+		restore_value(in, r.addr);
+		restore_value(in, r.done_time);
+	}
+
+	StubBackend::StubBackend(uint id, uint64_t delay)
+	{
+		this->systemID = id;
+		this->delay = delay;
+
+		ReadDone = NULL;
+		WriteDone = NULL;
+		currentClockCycle = 0;
+
+		reads = 0;
+		writes = 0;
+	}
+
+	bool StubBackend::addTransaction(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		assert(size > 0);
+
+		in_flight.push_back(StubRequest(isWrite, addr, currentClockCycle + delay));
+		if (isWrite)
+			writes++;
+		else
+			reads++;
+
+		return true;
+	}
+
+	void StubBackend::update()
+	{
+		while ((!in_flight.empty()) && (in_flight.front().done_time <= currentClockCycle))
+		{
+			StubRequest r = in_flight.front();
+			in_flight.pop_front();
+
+			BackendCompleteCB *cb = r.isWrite ? WriteDone : ReadDone;
+			if (cb != NULL)
+				(*cb)(systemID, r.addr, currentClockCycle);
+		}
+
+		currentClockCycle++;
+	}
+
+	void StubBackend::RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone)
+	{
+		ReadDone = readDone;
+		WriteDone = writeDone;
+	}
+
+	void StubBackend::printLogfile(ostream &out)
+	{
+		out << "PCI_SSD stub backend (" << delay << " ns per request)\n";
+		out << "\treads: " << reads << "\n";
+		out << "\twrites: " << writes << "\n";
+	}
+
+	uint64_t StubBackend::Max_Request_Size()
+	{
+		return 0;
+	}
+
+	void StubBackend::Functional_Access(bool isWrite, uint64_t addr, uint64_t size)
+	{
+		// Nothing outlives a request.
+	}
+
+	void StubBackend::Save(ostream &out)
+	{
+		save_value(out, currentClockCycle);
+		save_value(out, in_flight);
+		save_value(out, reads);
+		save_value(out, writes);
+	}
+
+	void StubBackend::Restore(istream &in)
+	{
+		restore_value(in, currentClockCycle);
+		restore_value(in, in_flight);
+		restore_value(in, reads);
+		restore_value(in, writes);
+	}
+}
@@ -0,0 +1,90 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_STUBBACKEND_H
+#define PCI_SSD_STUBBACKEND_H
+
+#include "Backend.h"
+
+namespace PCISSD
+{
+	class StubRequest
+	{
+		public:
+		bool isWrite;
+		uint64_t addr;
+		uint64_t done_time;
+
+		StubRequest() {}
+
+		StubRequest(bool w, uint64_t a, uint64_t t)
+		{
+			isWrite = w;
+			addr = a;
+			done_time = t;
+		}
+	};
+
+	// Fixed latency backend with unlimited parallelism.
+	// Every request completes STUB_DELAY ns after it arrives, so the rest of PCI_SSD can be timed and
+	// benchmarked without the cost or the queueing of a storage model.
+	class StubBackend : public Backend
+	{
+		public:
+		StubBackend(uint id, uint64_t delay);
+
+		bool addTransaction(bool isWrite, uint64_t addr, uint64_t size);
+		void update();
+		void RegisterCallbacks(BackendCompleteCB *readDone, BackendCompleteCB *writeDone);
+		void printLogfile(ostream &out);
+		uint64_t Max_Request_Size();
+		void Functional_Access(bool isWrite, uint64_t addr, uint64_t size);
+		void Save(ostream &out);
+		void Restore(istream &in);
+
+		// Parameters
+		uint systemID;
+		uint64_t delay;
+
+		// Internal state
+		BackendCompleteCB *ReadDone;
+		BackendCompleteCB *WriteDone;
+		uint64_t currentClockCycle;
+
+		list<StubRequest> in_flight; // In completion order, since every request takes the same time.
+
+		// Stats
+		uint64_t reads;
+		uint64_t writes;
+	};
+}
+
+#endif
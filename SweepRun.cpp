@@ -0,0 +1,254 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "SweepRun.h"
+#include <algorithm>
+#include <chrono>
+
+using namespace std;
+using namespace PCISSD;
+
+SweepRun::SweepRun(uint id, Config config, const Workload *workload, uint64_t queue_depth)
+{
+	assert(queue_depth > 0);
+
+	this->id = id;
+	this->config = config;
+	this->workload = workload;
+	this->queue_depth = queue_depth;
+	sg_entry_size = 0;
+	host_delay = 0;
+	completion_log = NULL;
+
+	mem = NULL;
+	host_cycle = 0;
+	reads = 0;
+	writes = 0;
+	bytes = 0;
+	sim_cycles = 0;
+	wall_seconds = 0;
+}
+
+void SweepRun::Run()
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	mem = new PCI_SSD_System(id, config);
+
+	typedef CallbackBase<void,uint,uint64_t,uint64_t> Callback_t;
+	Callback_t *read_cb = new Callback<SweepRun, void, uint, uint64_t, uint64_t>(this, &SweepRun::read_complete);
+	Callback_t *write_cb = new Callback<SweepRun, void, uint, uint64_t, uint64_t>(this, &SweepRun::write_complete);
+	mem->RegisterCallbacks(read_cb, write_cb);
+
+	// Every request in flight gets a host buffer twice its size, so its SG entries can leave gaps.
+	Callback_t *dma_cb = NULL;
+	if (sg_entry_size != 0)
+	{
+		assert(sg_entry_size == DRAMSIM_ALIGN(sg_entry_size));
+		for (uint64_t i=0; i < queue_depth; i++)
+			free_buffers.push_back(i * 2 * MAX_SECTORS * SECTOR_SIZE);
+		dma_cb = new Callback<SweepRun, void, uint, uint64_t, uint64_t>(this, &SweepRun::dma_request);
+		mem->RegisterDMACallback(dma_cb, queue_depth * 2 * MAX_SECTORS * SECTOR_SIZE);
+	}
+
+	// Issue requests once their cycle comes up, as long as the queue has room and they don't touch a sector
+	// that is still in flight (the simulator only allows one access per sector at a time).
+	const vector<WorkloadOp> &ops = workload->ops;
+	uint64_t next = 0;
+	uint64_t cycle = 0;
+	while ((next < ops.size()) || (!outstanding.empty()))
+	{
+		while ((next < ops.size()) && (outstanding.size() < queue_depth) && (ops[next].cycle <= cycle) 
+				&& (!Sectors_Busy(ops[next])) && (mem->WillAcceptTransaction()))
+		{
+			const WorkloadOp &op = ops[next];
+			for (uint64_t i=0; i < op.num_sectors; i++)
+				busy_sectors.insert(SECTOR_ALIGN(op.addr) + i * SECTOR_SIZE);
+			outstanding[op.addr] = next;
+			issue_cycle[op.addr] = mem->currentClockCycle;
+
+			if (sg_entry_size != 0)
+				Add_SG_Entries(op);
+			mem->addTransaction(op.isWrite, op.addr, op.num_sectors, op.qos_class);
+			next++;
+		}
+
+		if (sg_entry_size != 0)
+			Update_Host(cycle);
+
+		mem->update();
+		cycle++;
+	}
+
+	sim_cycles = mem->currentClockCycle;
+	sort(latencies.begin(), latencies.end());
+	sort(read_latencies.begin(), read_latencies.end());
+	sort(write_latencies.begin(), write_latencies.end());
+
+	delete mem;
+	mem = NULL;
+
+	// The system doesn't own its callbacks, so they go once it is gone.
+	delete read_cb;
+	delete write_cb;
+	delete dma_cb;
+
+	wall_seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+bool SweepRun::Sectors_Busy(const WorkloadOp &op)
+{
+	if (outstanding.count(op.addr) != 0)
+		return true;
+
+	for (uint64_t i=0; i < op.num_sectors; i++)
+	{
+		if (busy_sectors.count(SECTOR_ALIGN(op.addr) + i * SECTOR_SIZE) != 0)
+			return true;
+	}
+
+	return false;
+}
+
+void SweepRun::Add_SG_Entries(const WorkloadOp &op)
+{
+	assert(!free_buffers.empty());
+	uint64_t buffer = free_buffers.front();
+	free_buffers.pop_front();
+	host_buffer[op.addr] = buffer;
+
+	uint64_t bytes = op.num_sectors * SECTOR_SIZE;
+	for (uint64_t offset=0; offset < bytes; offset += sg_entry_size)
+		mem->AddDMAScatterGatherEntry(buffer + 2 * offset, min(sg_entry_size, bytes - offset));
+}
+
+void SweepRun::Update_Host(uint64_t cycle)
+{
+	host_cycle = cycle;
+	while ((!host_accesses.empty()) && (host_accesses.front().done_cycle <= cycle))
+	{
+		HostAccess a = host_accesses.front();
+		host_accesses.pop_front();
+		mem->CompleteDMATransaction(a.isWrite, a.addr);
+	}
+}
+
+void SweepRun::dma_request(uint isWrite, uint64_t addr, uint64_t unused)
+{
+	HostAccess a;
+	a.done_cycle = host_cycle + host_delay;
+	a.isWrite = isWrite;
+	a.addr = addr;
+	host_accesses.push_back(a);
+}
+
+void SweepRun::read_complete(uint id, uint64_t address, uint64_t clock_cycle)
+{
+	Transaction_Complete(address, clock_cycle);
+}
+
+void SweepRun::write_complete(uint id, uint64_t address, uint64_t clock_cycle)
+{
+	Transaction_Complete(address, clock_cycle);
+}
+
+void SweepRun::Transaction_Complete(uint64_t address, uint64_t clock_cycle)
+{
+	assert(outstanding.count(address) == 1);
+	const WorkloadOp &op = workload->ops[outstanding[address]];
+
+	for (uint64_t i=0; i < op.num_sectors; i++)
+		busy_sectors.erase(SECTOR_ALIGN(op.addr) + i * SECTOR_SIZE);
+
+	uint64_t latency = clock_cycle - issue_cycle[address];
+	if (completion_log != NULL)
+		*completion_log << address << " " << op.isWrite << " " << issue_cycle[address] << " " << clock_cycle << "\n";
+
+	if (op.isWrite)
+	{
+		writes++;
+		write_latencies.push_back(latency);
+	}
+	else
+	{
+		reads++;
+		read_latencies.push_back(latency);
+	}
+	bytes += op.num_sectors * SECTOR_SIZE;
+	latencies.push_back(latency);
+
+	outstanding.erase(address);
+	issue_cycle.erase(address);
+
+	if (sg_entry_size != 0)
+	{
+		free_buffers.push_back(host_buffer[address]);
+		host_buffer.erase(address);
+	}
+}
+
+uint64_t SweepRun::Percentile(double p)
+{
+	return Percentile(latencies, p);
+}
+
+uint64_t SweepRun::Percentile(vector<uint64_t> &sorted, double p)
+{
+	// Nearest rank.
+	if (sorted.empty())
+		return 0;
+	uint64_t rank = (uint64_t)ceil(p / 100.0 * sorted.size());
+	return sorted[max(rank, (uint64_t)1) - 1];
+}
+
+string SweepRun::CSV_Header()
+{
+	return "status,requests,reads,writes,sim_ns,iops,mb_per_s,mean_ns,p50_ns,p90_ns,p99_ns,p99.9_ns,max_ns,wall_s";
+}
+
+string SweepRun::CSV_Row()
+{
+	double mean = 0;
+	for (uint64_t i=0; i < latencies.size(); i++)
+		mean += latencies[i];
+	if (!latencies.empty())
+		mean /= latencies.size();
+
+	// The internal clock runs at 1 GHz, so cycles are ns.
+	double seconds = sim_cycles / 1e9;
+
+	stringstream row;
+	row << "ok," << latencies.size() << "," << reads << "," << writes << "," << sim_cycles << ","
+		<< ((seconds > 0) ? (reads + writes) / seconds : 0) << "," << ((seconds > 0) ? bytes / seconds / 1e6 : 0) << ","
+		<< mean << "," << Percentile(50) << "," << Percentile(90) << "," << Percentile(99) << "," << Percentile(99.9) << ","
+		<< (latencies.empty() ? 0 : latencies.back()) << "," << wall_seconds;
+	return row.str();
+}
@@ -0,0 +1,102 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_SWEEPRUN_H
+#define PCI_SSD_SWEEPRUN_H
+
+#include "PCI_SSD_System.h"
+#include "Workload.h"
+
+// A DMA access made by the system to host memory.
+class HostAccess
+{
+	public:
+	uint64_t done_cycle;
+	bool isWrite;
+	uint64_t addr;
+};
+
+// One point of a parameter sweep: a PCI_SSD_System built from config, driven by workload with at most
+// queue_depth requests outstanding.
+// With sg_entry_size set, every request moves its data by DMA from a scatter gather list of entries that
+// size, spread out over a host buffer of its own. Host memory answers every DMA access host_delay external
+// cycles after it is made.
+// With completion_log set, every completion is written to it as "address isWrite issue_cycle completion_cycle".
+class SweepRun
+{
+	public:
+		SweepRun(uint id, PCISSD::Config config, const PCISSD::Workload *workload, uint64_t queue_depth);
+
+		void Run();
+		string CSV_Row();
+		static string CSV_Header();
+
+		void read_complete(uint, uint64_t, uint64_t);
+		void write_complete(uint, uint64_t, uint64_t);
+		void dma_request(uint, uint64_t, uint64_t);
+
+		// Internal functions
+		void Transaction_Complete(uint64_t address, uint64_t clock_cycle);
+		bool Sectors_Busy(const PCISSD::WorkloadOp &op);
+		void Add_SG_Entries(const PCISSD::WorkloadOp &op);
+		void Update_Host(uint64_t cycle);
+		uint64_t Percentile(double p);
+		static uint64_t Percentile(vector<uint64_t> &sorted, double p);
+
+		uint id;
+		PCISSD::Config config;
+		const PCISSD::Workload *workload;
+		uint64_t queue_depth;
+		uint64_t sg_entry_size; // Bytes, or 0 to run without DMA.
+		uint64_t host_delay;
+		ostream *completion_log;
+
+		PCISSD::PCI_SSD_System *mem;
+		unordered_map<uint64_t, uint64_t> outstanding; // Index in the workload of each request in flight, by address.
+		unordered_map<uint64_t, uint64_t> issue_cycle;
+		set<uint64_t> busy_sectors;
+		list<uint64_t> free_buffers; // Host buffers not used by a request in flight.
+		unordered_map<uint64_t, uint64_t> host_buffer; // Host buffer of each request in flight, by address.
+		list<HostAccess> host_accesses; // DMA accesses in flight, in completion order.
+		uint64_t host_cycle;
+
+		// Results
+		uint64_t reads;
+		uint64_t writes;
+		uint64_t bytes;
+		uint64_t sim_cycles; // Internal cycles (ns) from the first request to the last completion.
+		vector<uint64_t> latencies; // ns, sorted once the run is done.
+		vector<uint64_t> read_latencies;
+		vector<uint64_t> write_latencies;
+		double wall_seconds;
+};
+
+#endif
@@ -0,0 +1,437 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+// Parameter sweep driver.
+// Runs a workload against every point in a grid of config settings, several points at a time, and
+// writes one CSV row of throughput and latency percentiles per point.
+//
+// Usage: PCI_SSD_Sweep [-j JOBS] [-t] [-c CONFIG] [-o CSV] [-r [-m MAX_QD] [-g GAIN]] WORKLOAD=SPEC[,SPEC...] [QUEUE_DEPTH=N[,N...]] [KEY=V1[,V2...] ...]
+//     -j JOBS    number of points to run at once (default: number of cores)
+//     -t         run points on threads instead of forked processes (flash or stub backend only, since HybridSim is not thread safe)
+//     -c CONFIG  ini file applied to every point before the sweep settings
+//     -o CSV     output file (default: stdout)
+//     -r         ramp the load at every point to find where it saturates (see run_ramp()), instead of a fixed QUEUE_DEPTH
+//     -m MAX_QD  largest queue depth to ramp to (default: 1024)
+//     -g GAIN    throughput gain in percent below which a step counts as past the knee (default: 10)
+// KEY is any config.h setting. Each KEY=V1,V2 adds an axis to the grid. Points run in forked processes by
+// default, so a point that fails an assert is reported as failed without stopping the sweep.
+// See Workload.h for the workload specs. QUEUE_DEPTH defaults to 32.
+
+#include "SweepRun.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+using namespace PCISSD;
+
+// Quote a CSV field if it needs it.
+string csv_field(string value)
+{
+	if (value.find_first_of(",\" ") == string::npos)
+		return value;
+
+	string quoted = "\"";
+	for (size_t i=0; i < value.size(); i++)
+	{
+		if (value[i] == '"')
+			quoted += "\"";
+		quoted += value[i];
+	}
+	return quoted + "\"";
+}
+
+class SweepPoint
+{
+	public:
+	uint id; // Distinct for every point, so the points never share backend ids or debug files.
+	Config config;
+	const Workload *workload;
+	uint64_t queue_depth;
+	uint64_t ramp_max; // Largest queue depth of a load ramp, or 0 to run at queue_depth.
+	uint64_t ramp_gain;
+	string settings; // CSV fields for the grid axes.
+	string result; // One or more CSV rows, without the settings.
+};
+
+// One step of a load ramp. Index 0 is every request, 1 is reads and 2 is writes.
+class RampStep
+{
+	public:
+	uint64_t queue_depth;
+	uint64_t requests[3];
+	double iops[3];
+	uint64_t p50[3];
+	uint64_t p99[3];
+};
+
+const char *RAMP_OPS[3] = {"all", "read", "write"};
+
+string ramp_header()
+{
+	return "queue_depth,op,requests,iops,p50_ns,p99_ns,saturation";
+}
+
+// Load ramp for one point. The queue depth doubles every step, until the throughput gains less than
+// ramp_gain percent over the step before (the knee) or ramp_max is reached. The saturation point of each
+// op type is the first step within ramp_gain percent of its peak throughput.
+// Returns one row per step and op type, with 1 in the saturation column at the saturation point.
+string run_ramp(SweepPoint &p)
+{
+	vector<RampStep> steps;
+	for (uint64_t qd=1; qd <= p.ramp_max; qd *= 2)
+	{
+		SweepRun run(p.id, p.config, p.workload, qd);
+		run.Run();
+
+		// The internal clock runs at 1 GHz, so cycles are ns.
+		double seconds = run.sim_cycles / 1e9;
+		vector<uint64_t> *latencies[3] = {&run.latencies, &run.read_latencies, &run.write_latencies};
+
+		RampStep s;
+		s.queue_depth = qd;
+		for (int o=0; o < 3; o++)
+		{
+			s.requests[o] = latencies[o]->size();
+			s.iops[o] = (seconds > 0) ? latencies[o]->size() / seconds : 0;
+			s.p50[o] = SweepRun::Percentile(*latencies[o], 50);
+			s.p99[o] = SweepRun::Percentile(*latencies[o], 99);
+		}
+		steps.push_back(s);
+
+		if ((steps.size() > 1) && (s.iops[0] * 100 < steps[steps.size()-2].iops[0] * (100 + p.ramp_gain)))
+			break;
+	}
+
+	stringstream rows;
+	for (int o=0; o < 3; o++)
+	{
+		double peak = 0;
+		for (uint64_t i=0; i < steps.size(); i++)
+			peak = max(peak, steps[i].iops[o]);
+
+		// Op types the workload doesn't have get no rows.
+		if (peak == 0)
+			continue;
+
+		bool found = false;
+		for (uint64_t i=0; i < steps.size(); i++)
+		{
+			RampStep &s = steps[i];
+			bool saturation = (!found) && (s.iops[o] * 100 >= peak * (100 - p.ramp_gain));
+			found = found || saturation;
+
+			rows << s.queue_depth << "," << RAMP_OPS[o] << "," << s.requests[o] << "," << s.iops[o] << "," 
+				<< s.p50[o] << "," << s.p99[o] << "," << saturation << "\n";
+		}
+	}
+
+	return rows.str();
+}
+
+string run_point(SweepPoint &p)
+{
+	if (p.ramp_max != 0)
+		return run_ramp(p);
+
+	SweepRun run(p.id, p.config, p.workload, p.queue_depth);
+	run.Run();
+	return run.CSV_Row();
+}
+
+void run_processes(vector<SweepPoint> &points, uint64_t jobs, string header)
+{
+	// A failed point gets an empty row.
+	string failed = "failed" + string(count(header.begin(), header.end(), ','), ',');
+
+	unordered_map<pid_t, pair<uint64_t, int>> running; // Point index and pipe of each child.
+	uint64_t next = 0;
+	uint64_t done = 0;
+
+	while (done < points.size())
+	{
+		while ((next < points.size()) && (running.size() < jobs))
+		{
+			int fds[2];
+			if (pipe(fds) != 0)
+			{
+				cerr << "ERROR: pipe() failed.\n";
+				abort();
+			}
+
+			cout.flush();
+			cerr.flush();
+			pid_t pid = fork();
+			if (pid < 0)
+			{
+				cerr << "ERROR: fork() failed.\n";
+				abort();
+			}
+			else if (pid == 0)
+			{
+				close(fds[0]);
+				string row = run_point(points[next]);
+				ssize_t written = write(fds[1], row.c_str(), row.size());
+				_exit((written == (ssize_t)row.size()) ? 0 : 1);
+			}
+
+			close(fds[1]);
+			running[pid] = make_pair(next, fds[0]);
+			next++;
+		}
+
+		int status;
+		pid_t pid = waitpid(-1, &status, 0);
+		if (running.count(pid) == 0)
+			continue;
+
+		uint64_t index = running[pid].first;
+		int fd = running[pid].second;
+		running.erase(pid);
+
+		string row;
+		char buf[4096];
+		ssize_t n;
+		while ((n = read(fd, buf, sizeof(buf))) > 0)
+			row.append(buf, n);
+		close(fd);
+
+		if ((!WIFEXITED(status)) || (WEXITSTATUS(status) != 0) || (row.empty()))
+			row = failed;
+		points[index].result = row;
+
+		done++;
+		cerr << "Sweep: " << done << "/" << points.size() << " points done\n";
+	}
+}
+
+void run_threads(vector<SweepPoint> &points, uint64_t jobs)
+{
+	atomic<uint64_t> next(0);
+	atomic<uint64_t> done(0);
+
+	vector<thread> workers;
+	for (uint64_t j=0; j < min(jobs, (uint64_t)points.size()); j++)
+	{
+		workers.push_back(thread([&]()
+		{
+			uint64_t index;
+			while ((index = next++) < points.size())
+			{
+				points[index].result = run_point(points[index]);
+				done++;
+			}
+		}));
+	}
+
+	for (uint64_t j=0; j < workers.size(); j++)
+		workers[j].join();
+
+	cerr << "Sweep: " << done << "/" << points.size() << " points done\n";
+}
+
+void usage()
+{
+	cerr << "Usage: PCI_SSD_Sweep [-j JOBS] [-t] [-c CONFIG] [-o CSV] [-r [-m MAX_QD] [-g GAIN]] WORKLOAD=SPEC[,SPEC...] [QUEUE_DEPTH=N[,N...]] [KEY=V1[,V2...] ...]\n";
+	exit(1);
+}
+
+int main(int argc, char *argv[])
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+	uint64_t jobs = (cores > 0) ? cores : 1;
+	bool use_threads = false;
+	bool ramp = false;
+	uint64_t ramp_max = 1024;
+	uint64_t ramp_gain = 10;
+	string config_file, output_file;
+
+	// Grid axes in the order they were given.
+	vector<pair<string, vector<string>>> axes;
+	bool have_workload = false;
+
+	for (int i=1; i < argc; i++)
+	{
+		string arg = argv[i];
+		if ((arg == "-j") && (i+1 < argc))
+			convert_uint64_t(jobs, argv[++i], "-j");
+		else if (arg == "-t")
+			use_threads = true;
+		else if ((arg == "-c") && (i+1 < argc))
+			config_file = argv[++i];
+		else if ((arg == "-o") && (i+1 < argc))
+			output_file = argv[++i];
+		else if (arg == "-r")
+			ramp = true;
+		else if ((arg == "-m") && (i+1 < argc))
+			convert_uint64_t(ramp_max, argv[++i], "-m");
+		else if ((arg == "-g") && (i+1 < argc))
+			convert_uint64_t(ramp_gain, argv[++i], "-g");
+		else if (arg.find("=") != string::npos)
+		{
+			size_t pos = arg.find("=");
+			string key = strip(arg.substr(0, pos));
+			list<string> values = split(arg.substr(pos+1), ",");
+			if (values.empty())
+				usage();
+			axes.push_back(make_pair(key, vector<string>(values.begin(), values.end())));
+			if (key == "WORKLOAD")
+				have_workload = true;
+		}
+		else
+			usage();
+	}
+
+	if ((!have_workload) || (jobs == 0) || (ramp_max == 0) || (ramp_gain >= 100))
+		usage();
+
+	Config base;
+	if (!config_file.empty())
+		base.Load(config_file);
+
+	// Load each workload once. Children and threads share them read only.
+	unordered_map<string, Workload *> workloads;
+	for (uint64_t a=0; a < axes.size(); a++)
+	{
+		if (axes[a].first != "WORKLOAD")
+			continue;
+		for (uint64_t v=0; v < axes[a].second.size(); v++)
+		{
+			string spec = strip(axes[a].second[v]);
+			if (workloads.count(spec) == 0)
+			{
+				workloads[spec] = new Workload();
+				workloads[spec]->Parse(spec);
+			}
+		}
+	}
+
+	// Expand the grid. The last axis changes fastest.
+	vector<SweepPoint> points;
+	vector<uint64_t> index(axes.size(), 0);
+	uint next_id = 0;
+	while (true)
+	{
+		SweepPoint p;
+		p.config = base;
+		p.workload = NULL;
+		p.queue_depth = 32;
+		p.ramp_max = ramp ? ramp_max : 0;
+		p.ramp_gain = ramp_gain;
+
+		stringstream settings;
+		for (uint64_t a=0; a < axes.size(); a++)
+		{
+			string key = axes[a].first;
+			string value = strip(axes[a].second[index[a]]);
+			if (key == "WORKLOAD")
+				p.workload = workloads[value];
+			else if ((key == "QUEUE_DEPTH") && (ramp))
+			{
+				cerr << "ERROR: QUEUE_DEPTH is ramped with -r, so it can't be a sweep axis too.\n";
+				abort();
+			}
+			else if (key == "QUEUE_DEPTH")
+				convert_uint64_t(p.queue_depth, value, key);
+			else
+				p.config.Set(key, value);
+			settings << csv_field(value) << ",";
+		}
+		p.settings = settings.str();
+		p.id = next_id;
+		next_id += p.config.num_devices;
+
+		// Catch bad settings before any time is spent on the sweep.
+		p.config.Validate();
+		if (p.queue_depth == 0)
+		{
+			cerr << "ERROR: QUEUE_DEPTH must be at least 1.\n";
+			abort();
+		}
+		if ((use_threads) && (p.config.backend_type == BACKEND_HYBRIDSIM))
+		{
+			cerr << "ERROR: Threaded sweeps need the flash or stub backend. Leave out -t to run HybridSim points in separate processes.\n";
+			abort();
+		}
+
+		points.push_back(p);
+
+		// Advance to the next point.
+		int a = axes.size() - 1;
+		while ((a >= 0) && (++index[a] == axes[a].second.size()))
+		{
+			index[a] = 0;
+			a--;
+		}
+		if (a < 0)
+			break;
+	}
+
+	cerr << "Sweep: " << points.size() << " points on " << jobs << (use_threads ? " threads\n" : " processes\n");
+
+	string header = ramp ? ramp_header() : SweepRun::CSV_Header();
+	if (use_threads)
+		run_threads(points, jobs);
+	else
+		run_processes(points, jobs, header);
+
+	// Write the results in grid order.
+	ofstream out_file;
+	if (!output_file.empty())
+	{
+		out_file.open(output_file.c_str(), ios_base::out | ios_base::trunc);
+		if (!out_file.is_open())
+		{
+			cerr << "ERROR: Failed to open " << output_file << "\n";
+			abort();
+		}
+	}
+	ostream &out = output_file.empty() ? cout : out_file;
+
+	for (uint64_t a=0; a < axes.size(); a++)
+		out << axes[a].first << ",";
+	out << header << "\n";
+	for (uint64_t i=0; i < points.size(); i++)
+	{
+		// Ramps give several rows per point, and each of them gets the point's settings.
+		list<string> rows = split(points[i].result, "\n");
+		for (list<string>::iterator it = rows.begin(); it != rows.end(); it++)
+			out << points[i].settings << *it << "\n";
+	}
+
+	for (unordered_map<string, Workload *>::iterator it = workloads.begin(); it != workloads.end(); it++)
+		delete it->second;
+
+	return 0;
+}
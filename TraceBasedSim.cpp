@@ -38,15 +38,7 @@ using namespace PCISSD;
 
 const uint64_t MAX_PENDING = 36;
 const uint64_t MIN_PENDING = 35;
-uint64_t complete = 0;
-uint64_t pending = 0;
-uint64_t throttle_count = 0;
-
-// The cycle counter is used to keep track of what cycle we are on.
-uint64_t cycle_counter = 0;
-
-uint64_t last_clock = 0;
-uint64_t CLOCK_DELAY = 1000000;
+const uint64_t CLOCK_DELAY = 1000000;
 
 
 int main(int argc, char *argv[])
@@ -62,14 +54,57 @@ int main(int argc, char *argv[])
 	else
 	cout << "Using default trace file (traces/test.txt)\n";
 
-	obj.run_trace(tracefile);
+	// Any other arguments are config files or KEY=VALUE overrides, applied in order.
+	Config config;
+	for (int i=2; i < argc; i++)
+	{
+		string arg = argv[i];
+		size_t pos = arg.find("=");
+		if (pos == string::npos)
+		{
+			cout << "Using config file " << arg << "\n";
+			config.Load(arg);
+		}
+		else
+		{
+			cout << "Setting " << arg << "\n";
+			config.Set(strip(arg.substr(0, pos)), strip(arg.substr(pos+1)));
+		}
+	}
+
+	obj.run_trace(tracefile, config);
+}
+
+PCI_SSD_TBS::PCI_SSD_TBS()
+{
+	complete = 0;
+	pending = 0;
+	throttle_count = 0;
+	cycle_counter = 0;
+	last_clock = 0;
+
+	sample_start = 0;
+	sample_end = 0;
+	sample_requests = 0;
+	sample_latency = 0;
+	detailed_requests = 0;
+	functional_requests = 0;
 }
 
-void transaction_complete(uint64_t clock_cycle)
+void PCI_SSD_TBS::transaction_complete(uint64_t address, uint64_t clock_cycle)
 {
 	complete++;
 	pending--;
 
+	if (measured.count(address) != 0)
+	{
+		// Completions happen inside update(), before cycle_counter moves on.
+		sample_latency += cycle_counter - measured[address];
+		sample_requests++;
+		sample_end = cycle_counter;
+		measured.erase(address);
+	}
+
 	if ((complete % 10000 == 0) || (clock_cycle - last_clock > CLOCK_DELAY))
 	{
 		cout << "complete= " << complete << "\t\tpending= " << pending << "\t\t cycle_count= "<< clock_cycle << "\t\tthrottle_count=" << throttle_count << "\n";
@@ -84,19 +119,79 @@ void PCI_SSD_TBS::read_complete(uint id, uint64_t address, uint64_t clock_cycle)
 {
 	printf("[Callback] read complete: %d 0x%lx cycle=%lu\n", id, address, clock_cycle);
 
-	transaction_complete(clock_cycle);
+	transaction_complete(address, clock_cycle);
 }
 
 void PCI_SSD_TBS::write_complete(uint id, uint64_t address, uint64_t clock_cycle)
 {
 	printf("[Callback] write complete: %d 0x%lx cycle=%lu\n", id, address, clock_cycle);
 
-	transaction_complete(clock_cycle);
+	transaction_complete(address, clock_cycle);
+}
+
+void PCI_SSD_TBS::Start_Sample()
+{
+	sample_start = cycle_counter;
+	sample_end = cycle_counter;
+	sample_requests = 0;
+	sample_latency = 0;
+}
+
+void PCI_SSD_TBS::End_Sample()
+{
+	// Every measured request must be back before the window can be closed.
+	assert(measured.empty());
+
+	if (sample_requests == 0)
+		return;
+
+	window_latency.push_back((double)sample_latency / sample_requests);
+	window_cycles.push_back((double)(sample_end - sample_start) / sample_requests);
+	sample_requests = 0;
+}
+
+// Mean of the per-window values and the half width of its 95% confidence interval.
+static void sample_mean(vector<double> &samples, double &mean, double &half_width)
+{
+	mean = 0.0;
+	for (uint64_t i=0; i < samples.size(); i++)
+		mean += samples[i];
+	mean /= samples.size();
+
+	half_width = 0.0;
+	if (samples.size() < 2)
+		return;
+
+	double variance = 0.0;
+	for (uint64_t i=0; i < samples.size(); i++)
+		variance += (samples[i] - mean) * (samples[i] - mean);
+	variance /= (samples.size() - 1);
+
+	half_width = 1.96 * sqrt(variance / samples.size());
+}
+
+void PCI_SSD_TBS::Print_Samples(uint64_t total_requests)
+{
+	cout << "Sampled simulation: " << window_latency.size() << " windows, " << detailed_requests << " detailed requests, "
+			<< functional_requests << " functional requests\n";
+	if (window_latency.empty())
+		return;
+
+	double latency, latency_error, cycles, cycles_error;
+	sample_mean(window_latency, latency, latency_error);
+	sample_mean(window_cycles, cycles, cycles_error);
+
+	cout << "\tmean latency: " << latency << " cycles (95% confidence: +/- " << latency_error << ")\n";
+	cout << "\tcycles per request: " << cycles << " (95% confidence: +/- " << cycles_error << ")\n";
+	cout << "\testimated cycles for the whole trace: " << (uint64_t)(cycles * total_requests) 
+			<< " (95% confidence: +/- " << (uint64_t)(cycles_error * total_requests) << ")\n";
+	if (window_latency.size() < 2)
+		cout << "\tAt least two windows are needed for a confidence interval.\n";
 }
 
-int PCI_SSD_TBS::run_trace(string tracefile)
+int PCI_SSD_TBS::run_trace(string tracefile, Config config)
 {
-	PCI_SSD_System *mem = new PCI_SSD_System(1);
+	PCI_SSD_System *mem = new PCI_SSD_System(1, config);
 
 
 	/* create and register our callback functions */
@@ -118,8 +213,28 @@ int PCI_SSD_TBS::run_trace(string tracefile)
 	char char_line[256];
 	string line;
 
+	// Sampled simulation. Requests past the detailed window of each period only update functional state,
+	// and the trace time they cover is skipped so the next window starts right away.
+	uint64_t sample_period = config.sample_period;
+	uint64_t detailed_length = config.sample_warmup + config.sample_window;
+	uint64_t request_index = 0;
+	uint64_t skipped_cycles = 0;
+	bool fast_forward = false;
+
+	// Host time spent reading the trace, for the profile.
+	chrono::steady_clock::duration parse_time = chrono::steady_clock::duration::zero();
+
 	while (inFile.good())
 	{
+		// Stop once the steady state statistics are tight enough (only with STATS_CONFIDENCE set).
+		if (mem->isConverged())
+		{
+			cout << "Statistics converged at cycle " << mem->currentClockCycle << ". Stopping the trace early.\n";
+			break;
+		}
+
+		chrono::steady_clock::time_point parse_start = chrono::steady_clock::now();
+
 		// Read the next line.
 		inFile.getline(char_line, 256);
 		line = (string)char_line;
@@ -135,18 +250,18 @@ int PCI_SSD_TBS::run_trace(string tracefile)
 		if (line.empty())
 			continue;
 
-		// Split and parse.
+		// Split and parse. The fourth number is an optional QoS class.
 		list<string> split_line = split(line);
 
-		if (split_line.size() != 3)
+		if ((split_line.size() != 3) && (split_line.size() != 4))
 		{
 			cout << "ERROR: Parsing trace failed on line:\n" << line << "\n";
-			cout << "There should be exactly three numbers per line\n";
+			cout << "There should be three or four numbers per line\n";
 			cout << "There are " << split_line.size() << endl;
 			abort();
 		}
 
-		uint64_t line_vals[3];
+		uint64_t line_vals[4] = {0, 0, 0, 0};
 
 		int i = 0;
 		for (list<string>::iterator it = split_line.begin(); it != split_line.end(); it++, i++)
@@ -161,18 +276,64 @@ int PCI_SSD_TBS::run_trace(string tracefile)
 		uint64_t trans_cycle = line_vals[0];
 		bool write = line_vals[1] % 2;
 		uint64_t addr = line_vals[2];
+		uint qos_class = line_vals[3];
+		if (qos_class >= NUM_QOS_CLASSES)
+		{
+			cout << "ERROR: Parsing trace failed on line:\n" << line << "\n";
+			cout << "The QoS class must be less than " << NUM_QOS_CLASSES << "\n";
+			abort();
+		}
+
+		parse_time += chrono::steady_clock::now() - parse_start;
+
+		uint64_t position = (sample_period == 0) ? 0 : request_index % sample_period;
+		request_index++;
+
+		if ((sample_period != 0) && (position >= detailed_length))
+		{
+			if (!fast_forward)
+			{
+				// Finish the detailed window before fast-forwarding, so its measured requests all complete.
+				while (pending > 0)
+				{
+					mem->update();
+					cycle_counter++;
+				}
+				End_Sample();
+				fast_forward = true;
+			}
+
+			mem->addFunctionalTransaction(write, addr, 1);
+			functional_requests++;
+			continue;
+		}
+
+		if (fast_forward)
+		{
+			// Resume at the current cycle, as if the fast-forwarded part of the trace took no time.
+			if (trans_cycle > cycle_counter + skipped_cycles)
+				skipped_cycles = trans_cycle - cycle_counter;
+			fast_forward = false;
+		}
 
 		// increment the counter until >= the clock cycle of cur transaction
 		// for each cycle, call the update() function.
-		while (cycle_counter < trans_cycle)
+		while (cycle_counter + skipped_cycles < trans_cycle)
 		{
 			mem->update();
 			cycle_counter++;
 		}
 
+		if ((sample_period != 0) && (position == config.sample_warmup))
+			Start_Sample();
+
 		// add the transaction and continue
-		mem->addTransaction(write, addr, 1);
+		mem->addTransaction(write, addr, 1, qos_class);
 		pending++;
+		detailed_requests++;
+
+		if ((sample_period != 0) && (position >= config.sample_warmup))
+			measured[addr] = cycle_counter;
 
 		// If the pending count goes above MAX_PENDING, wait until it goes back below MIN_PENDING before adding more 
 		// transactions. This throttling will prevent the memory system from getting overloaded.
@@ -207,6 +368,14 @@ int PCI_SSD_TBS::run_trace(string tracefile)
 
 	cout << "\n\n" << mem->currentClockCycle << ": completed " << complete << "\n\n";
 	cout << "TBS cycle_counter: " << cycle_counter << "\n";
+
+	if (sample_period != 0)
+	{
+		if (!fast_forward)
+			End_Sample();
+		Print_Samples(request_index);
+		cout << "\n";
+	}
 	//cout << "dram_pending=" << mem->dram_pending.size() << " flash_pending=" << mem->flash_pending.size() << "\n\n";
 	//cout << "dram_queue=" << mem->dram_queue.size() << " flash_queue=" << mem->flash_queue.size() << "\n\n";
 	//cout << "pending_pages=" << mem->pending_pages.size() << "\n\n";
@@ -230,6 +399,9 @@ int PCI_SSD_TBS::run_trace(string tracefile)
 	
 	mem->printLogfile();
 
+	if (config.enable_profile)
+		cout << "TBS trace parsing: " << chrono::duration<double>(parse_time).count() << " s\n";
+
 	//for (int i=0; i<500; i++)
 	//{
 	//	mem->update();
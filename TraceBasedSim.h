@@ -30,13 +30,41 @@
 
 
 #include "PCI_SSD_System.h"
+#include <chrono>
 
 
 
 class PCI_SSD_TBS
 {
 	public: 
+		PCI_SSD_TBS();
 		void read_complete(uint, uint64_t, uint64_t);
 		void write_complete(uint, uint64_t, uint64_t);
-		int run_trace(string tracefile);
+		void transaction_complete(uint64_t address, uint64_t clock_cycle);
+		int run_trace(string tracefile, PCISSD::Config config);
+
+		// Sampled simulation functions
+		void Start_Sample();
+		void End_Sample();
+		void Print_Samples(uint64_t total_requests);
+
+		uint64_t complete;
+		uint64_t pending;
+		uint64_t throttle_count;
+
+		// The cycle counter is used to keep track of what cycle we are on.
+		uint64_t cycle_counter;
+
+		uint64_t last_clock;
+
+		// Sampled simulation state
+		unordered_map<uint64_t, uint64_t> measured; // Issue cycle of each measured request that is still outstanding.
+		uint64_t sample_start; // Cycle the first measured request of the current window was issued.
+		uint64_t sample_end; // Cycle the last measured request of the current window completed.
+		uint64_t sample_requests;
+		uint64_t sample_latency;
+		vector<double> window_latency; // Mean latency of each finished window.
+		vector<double> window_cycles; // Cycles per request of each finished window.
+		uint64_t detailed_requests;
+		uint64_t functional_requests;
 };
@@ -36,6 +36,15 @@
 
 namespace PCISSD
 {
+	// Host transactions come from addTransaction() and are returned to the caller.
+	// The others are generated inside the SSD controller and never leave it.
+	enum TransactionOrigin
+	{
+		HOST_TRANSACTION,
+		DESTAGE_TRANSACTION,
+		PREFETCH_TRANSACTION
+	};
+
 	class Transaction
 	{
 		public:
@@ -45,10 +54,23 @@ namespace PCISSD
 		int num_sectors;
 		list<uint64_t> dma_sg_base; // scatter gather list
 		list<uint64_t> dma_sg_len;
+		TransactionOrigin origin;
+		list<Transaction> merged; // Original host transactions if this one was built by merging them.
+		uint device; // Device this transaction is routed to below Layer 1.
+		uint64_t parent_addr; // Address of the host transaction this stripe piece was split from.
+		uint64_t issue_time; // Cycle the host transaction arrived in addTransaction().
+		uint qos_class; // QoS class given to addTransaction(), 0 is the most important.
 
-		Transaction() {}
+		Transaction()
+		{
+			origin = HOST_TRANSACTION;
+			device = 0;
+			parent_addr = 0;
+			issue_time = 0;
+			qos_class = 0;
+		}
 
-		Transaction(bool w, uint64_t a, uint64_t o, int n, list<uint64_t> b, list<uint64_t> l)
+		Transaction(bool w, uint64_t a, uint64_t o, int n, list<uint64_t> b, list<uint64_t> l, TransactionOrigin org = HOST_TRANSACTION)
 		//Transaction(bool w, uint64_t a, uint64_t o, int n)
 		{
 			isWrite = w;
@@ -57,15 +79,21 @@ namespace PCISSD
 			num_sectors = n;
 			dma_sg_base = b;
 			dma_sg_len = l;
+			origin = org;
+			device = 0;
+			parent_addr = 0;
+			issue_time = 0;
+			qos_class = 0;
 		}
 	};
 
 	enum TransactionEventType
 	{
-		LAYER1_SEND_EVENT,
-		LAYER1_RETURN_EVENT,
-		LAYER2_SEND_EVENT,
-		LAYER2_RETURN_EVENT
+		LAYER_SEND_EVENT,
+		LAYER_RETURN_EVENT,
+		CACHE_HIT_EVENT,
+		PREFETCH_HIT_EVENT,
+		CONTROLLER_RETRY_EVENT
 	};
 
 	class TransactionEvent
@@ -74,6 +102,7 @@ namespace PCISSD
 		TransactionEventType type;
 		Transaction trans;
 		uint64_t expire_time;
+		uint layer; // Link that created a LAYER_SEND_EVENT or LAYER_RETURN_EVENT.
 
 		TransactionEvent() {}
 
@@ -82,6 +111,7 @@ namespace PCISSD
 			type = ty;
 			trans = tr;
 			expire_time = e;
+			layer = 0;
 		}
 
 		bool operator< (TransactionEvent &e)
@@ -0,0 +1,166 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#include "Workload.h"
+#include <random>
+
+namespace PCISSD
+{
+	Workload::Workload()
+	{
+		seed = 1;
+	}
+
+	void Workload::Parse(string spec)
+	{
+		this->spec = spec;
+
+		vector<string> fields;
+		list<string> split_spec = split(spec, ":");
+		fields.assign(split_spec.begin(), split_spec.end());
+
+		if ((fields.size() == 2) && (fields[0] == "trace"))
+		{
+			Load_Trace(fields[1]);
+			return;
+		}
+
+		if ((fields.size() < 2) || (fields.size() > 5) || ((fields[0] != "sequential") && (fields[0] != "random") && (fields[0] != "mixed"))
+				|| ((fields[0] == "sequential") && (fields.size() > 4)))
+		{
+			cerr << "ERROR: Invalid workload " << spec << " (expected trace:FILE, sequential:COUNT[:READ_PERCENT[:SECTORS]],"
+					<< " random:COUNT[:READ_PERCENT[:SECTORS[:FOOTPRINT]]] or mixed:COUNT[:READ_PERCENT[:READ_SECTORS[:WRITE_SECTORS]]])\n";
+			abort();
+		}
+
+		uint64_t count, read_percent = 100, num_sectors = 8, write_sectors = MAX_SECTORS, footprint = 1024*1024*1024;
+		if (fields[0] == "mixed")
+			read_percent = 70;
+		convert_uint64_t(count, fields[1], "workload count");
+		if (fields.size() > 2)
+			convert_uint64_t(read_percent, fields[2], "workload read percent");
+		if (fields.size() > 3)
+			convert_uint64_t(num_sectors, fields[3], "workload sectors");
+		if ((fields.size() > 4) && (fields[0] == "mixed"))
+			convert_uint64_t(write_sectors, fields[4], "workload write sectors");
+		else if (fields.size() > 4)
+			convert_uint64_t(footprint, fields[4], "workload footprint");
+
+		if ((read_percent > 100) || (num_sectors < MIN_SECTORS) || (num_sectors > MAX_SECTORS) || (footprint < num_sectors * SECTOR_SIZE)
+				|| (write_sectors < MIN_SECTORS) || (write_sectors > MAX_SECTORS))
+		{
+			cerr << "ERROR: Invalid workload " << spec << " (READ_PERCENT is 0 to 100, SECTORS and WRITE_SECTORS are " << MIN_SECTORS << " to " << MAX_SECTORS
+					<< " and FOOTPRINT must hold at least one request)\n";
+			abort();
+		}
+
+		if (fields[0] == "mixed")
+			Generate_Mixed(count, read_percent, num_sectors, write_sectors, footprint);
+		else
+			Generate(fields[0] == "sequential", count, read_percent, num_sectors, footprint);
+	}
+
+	void Workload::Load_Trace(string tracefile)
+	{
+		ifstream inFile;
+		inFile.open(tracefile.c_str(), ifstream::in);
+		if (!inFile.is_open())
+		{
+			cerr << "ERROR: Failed to load tracefile: " << tracefile << "\n";
+			abort();
+		}
+
+		string line;
+		while (getline(inFile, line))
+		{
+			// Filter comments out.
+			size_t pos = line.find("#");
+			line = strip(line.substr(0, pos));
+			if (line.empty())
+				continue;
+
+			// The fourth number is an optional QoS class.
+			list<string> split_line = split(line);
+			if ((split_line.size() != 3) && (split_line.size() != 4))
+			{
+				cerr << "ERROR: Parsing trace " << tracefile << " failed on line:\n" << line << "\n";
+				cerr << "There should be three or four numbers per line\n";
+				abort();
+			}
+
+			uint64_t line_vals[4] = {0, 0, 0, 0};
+			int i = 0;
+			for (list<string>::iterator it = split_line.begin(); it != split_line.end(); it++, i++)
+				convert_uint64_t(line_vals[i], *it, tracefile);
+
+			if (line_vals[3] >= NUM_QOS_CLASSES)
+			{
+				cerr << "ERROR: Parsing trace " << tracefile << " failed on line:\n" << line << "\n";
+				cerr << "The QoS class must be less than " << NUM_QOS_CLASSES << "\n";
+				abort();
+			}
+
+			ops.push_back(WorkloadOp(line_vals[0], line_vals[1] % 2, line_vals[2], 1, line_vals[3]));
+		}
+
+		inFile.close();
+	}
+
+	void Workload::Generate(bool sequential, uint64_t count, uint64_t read_percent, uint64_t num_sectors, uint64_t footprint)
+	{
+		mt19937_64 rng(seed);
+		uint64_t request_size = num_sectors * SECTOR_SIZE;
+		uint64_t slots = footprint / request_size;
+
+		for (uint64_t i=0; i < count; i++)
+		{
+			uint64_t slot = sequential ? (i % slots) : (rng() % slots);
+			bool write = (rng() % 100) >= read_percent;
+			ops.push_back(WorkloadOp(0, write, slot * request_size, num_sectors));
+		}
+	}
+
+	// Latency sensitive reads share the device with bulk writes, each in its own QoS class.
+	void Workload::Generate_Mixed(uint64_t count, uint64_t read_percent, uint64_t read_sectors, uint64_t write_sectors, uint64_t footprint)
+	{
+		mt19937_64 rng(seed);
+		uint64_t read_size = read_sectors * SECTOR_SIZE;
+		uint64_t write_size = write_sectors * SECTOR_SIZE;
+
+		for (uint64_t i=0; i < count; i++)
+		{
+			bool write = (rng() % 100) >= read_percent;
+			uint64_t request_size = write ? write_size : read_size;
+			uint64_t slot = rng() % (footprint / request_size);
+			ops.push_back(WorkloadOp(0, write, slot * request_size, write ? write_sectors : read_sectors, write ? 1 : 0));
+		}
+	}
+}
@@ -0,0 +1,85 @@
+/*********************************************************************************
+* Copyright (c) 2010-2011, 
+* Jim Stevens, Paul Tschirhart, Ishwar Singh Bhati, Mu-Tien Chang, Peter Enns, 
+* Elliott Cooper-Balis, Paul Rosenfeld, Bruce Jacob
+* University of Maryland
+* Contact: jims [at] cs [dot] umd [dot] edu
+* All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are met:
+*
+* * Redistributions of source code must retain the above copyright notice,
+* this list of conditions and the following disclaimer.
+*
+* * Redistributions in binary form must reproduce the above copyright notice,
+* this list of conditions and the following disclaimer in the documentation
+* and/or other materials provided with the distribution.
+*
+* THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+* ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+* DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+* FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+* DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+* SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+* CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+* OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+* OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*********************************************************************************/
+
+
+#ifndef PCI_SSD_WORKLOAD_H
+#define PCI_SSD_WORKLOAD_H
+
+#include "common.h"
+#include "config.h"
+
+namespace PCISSD
+{
+	class WorkloadOp
+	{
+		public:
+		uint64_t cycle; // External cycle the request arrives on (0 to issue as soon as the queue depth allows).
+		bool isWrite;
+		uint64_t addr;
+		uint num_sectors;
+		uint qos_class;
+
+		WorkloadOp(uint64_t c, bool w, uint64_t a, uint n, uint q = 0)
+		{
+			cycle = c;
+			isWrite = w;
+			addr = a;
+			num_sectors = n;
+			qos_class = q;
+		}
+	};
+
+	// A list of host requests for the drivers to replay.
+	// Workloads are described by a spec string:
+	//     trace:FILE                                      a trace in the TraceBasedSim format (cycle write addr [qos_class])
+	//     sequential:COUNT[:READ_PERCENT[:SECTORS]]       back to back requests through the footprint
+	//     random:COUNT[:READ_PERCENT[:SECTORS[:FOOTPRINT]]]  uniformly random aligned requests
+	//     mixed:COUNT[:READ_PERCENT[:READ_SECTORS[:WRITE_SECTORS]]]  random small reads in QoS class 0 mixed with
+	//                                                     large writes in class 1
+	// READ_PERCENT defaults to 100 (70 for mixed), SECTORS to 8 (4 KB), WRITE_SECTORS to 2048 (1 MB) and FOOTPRINT
+	// to 1 GB. Requests are in QoS class 0 unless stated otherwise. Synthetic workloads are generated from a fixed
+	// seed, so every run of a spec sees the same requests.
+	class Workload
+	{
+		public:
+		Workload();
+
+		void Parse(string spec);
+		void Load_Trace(string tracefile);
+		void Generate(bool sequential, uint64_t count, uint64_t read_percent, uint64_t num_sectors, uint64_t footprint);
+		void Generate_Mixed(uint64_t count, uint64_t read_percent, uint64_t read_sectors, uint64_t write_sectors, uint64_t footprint);
+
+		string spec;
+		vector<WorkloadOp> ops;
+		uint64_t seed;
+	};
+}
+
+#endif
@@ -46,9 +46,6 @@
 
 using namespace std;
 
-// External Interface for HybridSim
-#include <HybridSim.h>
-
 #include "ClockDomain.h"
 #include "CallbackPCI.h"
 #include "Transaction.h"
@@ -35,9 +35,16 @@
 ////////////////////////////////////////////////////////////////////
 // Set options here
 
-// Enable debugging output.
+// These are the defaults for each PCI_SSD_System. Everything from INTERNAL_CLOCK down to the
+// "should never change" line can be overridden at run time with an ini file of KEY=VALUE lines
+// using the same names (see Config.h). DEBUG and DEBUG_FILE are compile-time only.
+
+// Enable debugging output. The sweep driver is built with -DDEBUG=0.
+// Each PCI_SSD_System writes its own debug file. %i in DEBUG_FILE is replaced by the instance id.
+#ifndef DEBUG
 #define DEBUG 1
-#define DEBUG_FILE "debug_pci_ssd.txt"
+#endif
+#define DEBUG_FILE "debug_pci_ssd_%i.txt"
 //#define DEBUG_FILE "/dev/stdout"
 
 // Define clock ratio.
@@ -51,6 +58,21 @@
 #define INTERNAL_CLOCK 1
 #define EXTERNAL_CLOCK 2
 
+// Specify the storage backend behind the SSD controller.
+// BACKEND_HYBRIDSIM uses HybridSim (built from ../HybridSim).
+// BACKEND_FLASH uses the built-in analytic NAND flash model below. It is much faster than HybridSim
+// and has no external dependencies. Builds without HybridSim (NO_HYBRIDSIM) default to it.
+// BACKEND_STUB completes every request after STUB_DELAY ns, to time PCI_SSD itself (see BenchSim.cpp).
+#define BACKEND_HYBRIDSIM 0
+#define BACKEND_FLASH 1
+#define BACKEND_STUB 2
+
+#ifdef NO_HYBRIDSIM
+#define BACKEND_TYPE BACKEND_FLASH
+#else
+#define BACKEND_TYPE BACKEND_HYBRIDSIM
+#endif
+
 // Define a clock ratio for HybridSim.
 // HybridSim needs to be called 2 times for every 3 times this module is updated
 // since this module runs at 1 GHz and HybridSim runs at 667 MHz.
@@ -61,16 +83,43 @@
 #define HYBRIDSIM_INI "../HybridSim/ini/hybridsim.ini"
 //#define HYBRIDSIM_INI "hybridsim.ini"
 
+// Define the geometry of the analytic flash model.
+// Each channel is a shared bus to its dies. Dies work in parallel.
+#define FLASH_CHANNELS 8
+#define FLASH_DIES_PER_CHANNEL 4
+#define FLASH_PAGE_SIZE 4096
+#define FLASH_PAGES_PER_BLOCK 256
 
-// Define interface speeds in bytes per second
-#define SATA2 300000000 // SATA 2.0 (300 MB/s, 375 MB/s without PHY overhead) (Also can use this for SAS)
-#define SATA3 600000000 // SATA 3.0 (600 MB/s, 750 MB/s without PHY overhead) (Also can use this for SAS)
-#define PCI2 500000000  // PCIe 2.0 (500 MB/s per lane)
-#define PCI3 1000000000 // PCIe 3.0 (1 GB/s per lane)
-#define DMI2 2500000000 // Intel Direct Media Interface 2.0 (2.5 GB/s)
+// Define flash timing in ns. The flash model runs on the 1 GHz internal clock.
+// FLASH_READ_DELAY is tR, FLASH_PROGRAM_DELAY is tPROG and FLASH_ERASE_DELAY is tBERS.
+// A die erases a block after every FLASH_PAGES_PER_BLOCK programs.
+#define FLASH_READ_DELAY 25000
+#define FLASH_PROGRAM_DELAY 200000
+#define FLASH_ERASE_DELAY 1500000
+#define FLASH_COMMAND_DELAY 100
+
+// Define the flash channel speed in bytes per second.
+#define FLASH_CHANNEL_RATE 400000000 // ONFI 3 (400 MB/s)
+
+// Define the latency of every request to the stub backend in ns.
+#define STUB_DELAY 1000
+
+
+// Define interface types.
+// SATA and DMI apply PROTOCOL_EFFICIENCY to their data rate. PCIe links use the PCIe link model
+// (line encoding, TLP and DLLP overhead, and the payload and read request sizes below).
 #define NONE 0
+#define SATA2 1 // SATA 2.0 (300 MB/s, 375 MB/s without PHY overhead) (Also can use this for SAS)
+#define SATA3 2 // SATA 3.0 (600 MB/s, 750 MB/s without PHY overhead) (Also can use this for SAS)
+#define DMI2 3  // Intel Direct Media Interface 2.0 (2.5 GB/s)
+#define PCI1 4  // PCIe 1.x (2.5 GT/s per lane, 8b/10b)
+#define PCI2 5  // PCIe 2.0 (5 GT/s per lane, 8b/10b)
+#define PCI3 6  // PCIe 3.0 (8 GT/s per lane, 128b/130b)
+#define PCI4 7  // PCIe 4.0 (16 GT/s per lane, 128b/130b)
+#define PCI5 8  // PCIe 5.0 (32 GT/s per lane, 128b/130b)
+#define PCI6 9  // PCIe 6.0 (64 GT/s per lane, PAM4 with 256 byte FLITs)
 
-// Specify interface speeds for Layer 1 and Layer 2.
+// Specify interface types for Layer 1 and Layer 2.
 #define LAYER1_TYPE PCI3
 #define LAYER2_TYPE NONE
 
@@ -87,6 +136,104 @@
 #define LAYER1_FULL_DUPLEX 1
 #define LAYER2_FULL_DUPLEX 0
 
+// Specify whether layers should merge contiguous requests in their send queues (1) or not (0).
+// A merged transaction pays the command overhead once and is split back into the original
+// transactions when it completes. Merged transactions never exceed MAX_SECTORS.
+#define LAYER1_MERGE 0
+#define LAYER2_MERGE 0
+
+// Specify SATA Native Command Queuing for SATA links (SATA2 and SATA3).
+// Each SATA link holds up to NCQ_DEPTH commands at the device (at most 32 tags) and moves every command
+// as separate FISes: a Register H2D FIS to issue it, a DMA Setup FIS and Data FISes for its data, and a
+// Set Device Bits FIS to complete it. Write data is only sent once the command is at the device, so the
+// commands and data phases of different commands interleave on the link, and commands complete in the
+// order the device finishes them. Every FIS also pays SATA_FIS_OVERHEAD bytes of framing and handshake
+// primitives (SOF, CRC, EOF, X_RDY/R_RDY, R_OK).
+// Set NCQ_DEPTH to 0 for the simpler model, where a command carries its data and has no tag limit.
+#define NCQ_DEPTH 32
+#define SATA_FIS_OVERHEAD 32
+
+// Specify how every link picks the next transaction from its send and return queues.
+// Each host transaction has a QoS class from 0 (most important) to NUM_QOS_CLASSES-1, given to addTransaction().
+// SCHEDULER_FIFO serves transactions in the order they arrived.
+// SCHEDULER_PRIORITY serves the lowest class first, in arrival order within a class. Busy classes starve the rest.
+// SCHEDULER_WFQ shares the link between the classes in proportion to QOS_WEIGHTS (weighted fair queuing on request bytes).
+// SCHEDULER_READ_FIRST serves reads before writes, but passes over waiting writes at most SCHEDULER_WRITE_STARVATION times in a row.
+// SCHEDULER_DEADLINE serves the earliest deadline first. A transaction's deadline is the cycle it arrived in
+// addTransaction() plus the QOS_DEADLINES entry (in ns) of its class.
+// QOS_WEIGHTS and QOS_DEADLINES have one value per class, separated by spaces.
+#define SCHEDULER_FIFO 0
+#define SCHEDULER_PRIORITY 1
+#define SCHEDULER_WFQ 2
+#define SCHEDULER_READ_FIRST 3
+#define SCHEDULER_DEADLINE 4
+
+#define LAYER_SCHEDULER SCHEDULER_FIFO
+#define QOS_WEIGHTS "8 4 2 1"
+#define QOS_DEADLINES "100000 1000000 10000000 100000000"
+#define SCHEDULER_WRITE_STARVATION 4
+
+// PCIe link model settings.
+// Writes are split into TLPs of at most PCIE_MAX_PAYLOAD bytes. DMA reads are split into requests of
+// at most PCIE_MAX_READ_REQUEST bytes. Each request is answered with completions of
+// PCIE_READ_COMPLETION_BOUNDARY bytes, or up to PCIE_MAX_PAYLOAD bytes if the completer coalesces them.
+#define PCIE_MAX_PAYLOAD 256
+#define PCIE_MAX_READ_REQUEST 512
+#define PCIE_READ_COMPLETION_BOUNDARY 64
+#define PCIE_COMPLETION_COALESCING 1
+
+// TLP header size in bytes (16 with 64-bit addressing).
+#define PCIE_TLP_HEADER 16
+
+// Number of TLPs acknowledged by each ACK DLLP, and number of TLPs covered by each UpdateFC DLLP.
+#define PCIE_ACK_FACTOR 4
+#define PCIE_FC_UPDATE_FACTOR 4
+
+// Specify whether PCIe links use credit-based flow control (1) or not (0).
+// The receiver at each end of a link advertises header and data credits (16 bytes each) for posted,
+// non-posted and completion TLPs. A transfer only starts when the receiver has credits for it, and the
+// credits come back PCIE_CREDIT_RETURN_DELAY ns after the transfer finishes. A transfer that needs more
+// credits than the receiver advertises streams through the buffer, and waits for the credits to come
+// back each time it fills. A limit of 0 means infinite credits (endpoints advertise infinite completion credits).
+#define PCIE_FLOW_CONTROL 0
+#define PCIE_POSTED_HEADER_CREDITS 32
+#define PCIE_POSTED_DATA_CREDITS 128 // 2 KB
+#define PCIE_NON_POSTED_HEADER_CREDITS 32
+#define PCIE_NON_POSTED_DATA_CREDITS 32
+#define PCIE_COMPLETION_HEADER_CREDITS 0
+#define PCIE_COMPLETION_DATA_CREDITS 0
+#define PCIE_CREDIT_RETURN_DELAY 200
+
+// Specify whether PCIe links use active state power management (1) or not (0).
+// A link with nothing in flight in either direction enters L0s after ASPM_L0S_ENTRY ns and L1 after
+// ASPM_L1_ENTRY ns. The next transfer waits for the exit latency of the state the link is in.
+// An entry time of 0 disables that state.
+#define ENABLE_ASPM 0
+#define ASPM_L0S_ENTRY 7000
+#define ASPM_L0S_EXIT 1000
+#define ASPM_L1_ENTRY 32000
+#define ASPM_L1_EXIT 16000
+
+// Specify the number of SSDs behind Layer 1 and the stripe unit in bytes.
+// Each device gets its own Layer 2 link, backend, cache and prefetcher. Host addresses are
+// striped round-robin over the devices in STRIPE_SIZE chunks (RAID 0). A host transaction that
+// spans several stripes is split after Layer 1 and returned once every piece has completed.
+// STRIPE_SIZE must be a multiple of SECTOR_SIZE.
+#define NUM_DEVICES 1
+#define STRIPE_SIZE (64*1024) // 64 KB
+
+// Specify a custom interconnect topology. Leave this empty to use the Layer 1 and Layer 2 settings
+// above (one Layer 1 link from the host and one Layer 2 link per device).
+// Otherwise, list the links separated by spaces as name:type:lanes:duplex:parent[:merge].
+// type is one of the interface types above (SATA2, SATA3, DMI2, PCI1 to PCI6 or NONE), duplex is 1 for
+// full duplex, parent is the name of the upstream link ("host" for the root link) and merge is 1 to
+// merge contiguous requests on that link. There must be exactly one root link, and every link must be
+// listed after its parent. Links with no children connect to the devices in the order they are
+// listed, so there must be NUM_DEVICES of them. Host transactions are striped once they cross the root link.
+// Example: four SSDs behind a PCIe switch that share an x8 uplink.
+// "up:PCI3:8:1:host ssd0:PCI3:4:1:up ssd1:PCI3:4:1:up ssd2:PCI3:4:1:up ssd3:PCI3:4:1:up"
+#define TOPOLOGY ""
+
 
 // Specify whether direct memory access should be simulated.
 // If this is 0, the direct memory access parts will simply be skipped.
@@ -98,6 +245,79 @@
 #define MAX_PENDING_DMA 64
 
 
+// Specify whether the SSD controller has a DRAM cache in front of HybridSim.
+// If this is 0, every sector goes straight to HybridSim after Layer 2.
+#define ENABLE_CACHE 0
+
+// Cache capacity in bytes and associativity. Lines are one sector each.
+#define CACHE_SIZE (64*1024*1024) // 64 MB
+#define CACHE_WAYS 8
+
+// Specify whether the cache is write-back (1) or write-through (0).
+// Write-back completes writes at DRAM latency and destages dirty sectors to HybridSim later.
+// Write-through completes writes when HybridSim does and never holds dirty data.
+#define CACHE_WRITE_BACK 1
+
+// Cache hit latency in ns, plus the time to move each sector in or out of the DRAM.
+#define CACHE_HIT_DELAY 50
+#define CACHE_SECTOR_DELAY 40 // 512 bytes at 12.8 GB/s
+
+// Destage engine settings.
+// CACHE_MAX_DESTAGE is the number of destage writes that may be outstanding in HybridSim at once.
+// CACHE_DESTAGE_BUFFER is the number of evicted dirty sectors that may wait for a destage. Writes
+// stall while the dirty lines they would evict don't fit. It must hold at least MAX_SECTORS, so that
+// the largest write always fits once the buffer has drained.
+// Once more than CACHE_DIRTY_THRESHOLD percent of the lines are dirty, the oldest dirty lines are
+// drained in the background even if nothing evicts them.
+#define CACHE_MAX_DESTAGE 16
+#define CACHE_DESTAGE_BUFFER 2048
+#define CACHE_DIRTY_THRESHOLD 50
+
+
+// Specify whether the controller should detect sequential streams and read ahead of them.
+// Prefetched sectors are kept in a separate buffer in controller DRAM. Hits in that buffer
+// use CACHE_HIT_DELAY and CACHE_SECTOR_DELAY, even if ENABLE_CACHE is 0.
+#define ENABLE_PREFETCH 0
+
+// Number of streams tracked at once, and how many accesses in a row must match a stream's stride
+// before it starts prefetching.
+#define PREFETCH_STREAMS 8
+#define PREFETCH_THRESHOLD 2
+
+// Number of strides to prefetch ahead of demand once a stream is detected.
+#define PREFETCH_DEGREE 4
+
+// Largest stride in bytes that the detector will learn.
+#define PREFETCH_MAX_STRIDE (64*SECTOR_SIZE)
+
+// Maximum number of prefetch reads outstanding in HybridSim, and the size of the prefetch buffer in sectors.
+#define PREFETCH_MAX_OUTSTANDING 16
+#define PREFETCH_BUFFER_SIZE 1024
+
+// Sampled simulation in the trace driver. Out of every SAMPLE_PERIOD requests, the first SAMPLE_WARMUP +
+// SAMPLE_WINDOW are simulated in detail and the rest only update functional state (cache and prefetcher
+// contents, flash mapping). Latency and throughput are measured over the last SAMPLE_WINDOW requests of
+// each detailed window and extrapolated to the whole trace. A SAMPLE_PERIOD of 0 simulates everything in detail.
+#define SAMPLE_PERIOD 0
+#define SAMPLE_WARMUP 1000
+#define SAMPLE_WINDOW 1000
+
+// Steady state detection. Host completions are grouped into windows of STATS_WINDOW cycles. Steady state
+// begins once the throughput and mean latency of the last STEADY_WINDOWS windows each vary by less than
+// STEADY_THRESHOLD percent (coefficient of variation). Steady state stats leave out everything before it.
+// With a nonzero STATS_CONFIDENCE, the run counts as converged once the 95% confidence intervals of the
+// steady state throughput and latency are within STATS_CONFIDENCE percent of their means, and the trace
+// driver stops early at that point.
+#define STATS_WINDOW 1000000
+#define STEADY_WINDOWS 5
+#define STEADY_THRESHOLD 10
+#define STATS_CONFIDENCE 0
+
+// Specify whether the simulator should time its own parts (update(), layers, event queue, DMA, devices,
+// backend and host callbacks) with the host clock and print the breakdown with the other stats.
+#define ENABLE_PROFILE 0
+
+
 ////////////////////////////////////////////////////////////////////
 // Parameters below this point should never change.
 
@@ -116,22 +336,23 @@
 #define MIN_SECTORS 1 	// 512 bytes
 #define MAX_SECTORS 2048 // 1 MB
 
+// Specify the number of QoS classes.
+#define NUM_QOS_CLASSES 4
+
 // Specify command size for layers.
 #define COMMAND_SIZE 16
 
-// Specify protocol efficiency percentage.
+// Specify protocol efficiency percentage (for interfaces other than PCIe).
 #define PROTOCOL_EFFICIENCY 90
 
-// Compute layer 1 delays.
-#define LAYER1_COMMAND_DELAY compute_interface_delay(COMMAND_SIZE, LAYER1_TYPE, PROTOCOL_EFFICIENCY)
-#define LAYER1_DATA_DELAY compute_interface_delay(COMMAND_SIZE + SECTOR_SIZE, LAYER1_TYPE, PROTOCOL_EFFICIENCY)
-
-// Compute layer 2 delays.
-#define LAYER2_COMMAND_DELAY compute_interface_delay(COMMAND_SIZE, LAYER2_TYPE, PROTOCOL_EFFICIENCY)
-#define LAYER2_DATA_DELAY compute_interface_delay(COMMAND_SIZE + SECTOR_SIZE, LAYER2_TYPE, PROTOCOL_EFFICIENCY)
+// Specify SATA FIS sizes in bytes.
+#define SATA_REG_H2D_FIS 20
+#define SATA_DMA_SETUP_FIS 28
+#define SATA_SET_DEVICE_BITS_FIS 8
+#define SATA_DATA_FIS_HEADER 4
+#define SATA_MAX_DATA_FIS 8192
 
 // Other Derived Parameters
-#define HYBRIDSIM_TRANSACTIONS(ns) ((ns*SECTOR_SIZE) / HYBRIDSIM_TRANSACTION_SIZE)
 #define SECTOR_ALIGN(addr) ((addr / SECTOR_SIZE) * SECTOR_SIZE)
 #define DRAMSIM_ALIGN(addr) ((addr / DRAMSIM_TRANSACTION_SIZE) * DRAMSIM_TRANSACTION_SIZE)
 